@@ -12,14 +12,221 @@
 
 #if defined(__cplusplus)
 #include <atomic>
+#include <cstdint>
 #undef _Atomic
 #define _Atomic(T) std::atomic<T>
 #else
 #include <stdalign.h>
 #include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#endif
+
+#if defined(__x86_64__)
+#include <cpuid.h>
 #endif
 
 #define atomic_inc(p) (void)atomic_fetch_add(p, 1)
 #define atomic_dec(p) (void)atomic_fetch_sub(p, 1)
 
+/**
+ *  Spin-wait hint for busy loops.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define cpu_relax() __asm__ __volatile__("yield" ::: "memory")
+#else
+#define cpu_relax() __asm__ __volatile__("" ::: "memory")
+#endif
+
+/**
+ *  Distance that keeps fields written by different threads from sharing a
+ *  cache line. Two 64-byte lines on x86, whose adjacent-line prefetcher
+ *  moves lines in pairs.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+#define CACHE_LINE_BYTES 128
+#else
+#define CACHE_LINE_BYTES 64
+#endif
+
+/**
+ *  Keeps the primitives below inlined into the hot loops, even in the
+ *  -Og/-finstrument-functions test builds.
+ */
+#define ATOMIC_INLINE \
+    static inline __attribute__((always_inline, no_instrument_function))
+
+/**
+ *  Double-width word, the operand of the DWCAS primitives below.
+ *
+ *  Every structure handed to atomic_dw_*() must be exactly this size,
+ *  aligned to it and free of padding bytes, because the comparison is
+ *  done on the raw bits.
+ */
+typedef struct atomic_dw {
+    alignas(2 * sizeof(uintptr_t)) uintptr_t lo;
+    uintptr_t hi;
+} atomic_dw_t;
+
+#define ATOMIC_DW_FEATURE_PROBED (1U << 0)
+#define ATOMIC_DW_FEATURE_CX16   (1U << 1)
+#define ATOMIC_DW_FEATURE_AVX    (1U << 2)
+
+/**
+ *  Probes the CPU once for the instructions used by the DWCAS layer.
+ *
+ *  @c ATOMIC_DW_FEATURE_CX16 selects inline `lock cmpxchg16b`.
+ *  @c ATOMIC_DW_FEATURE_AVX additionally selects a plain `movdqa` for
+ *  loads, which the Intel SDM (Vol.3A 9.1.1) and AMD APM guarantee to be
+ *  single-copy atomic on processors that enumerate AVX.
+ *
+ *  @return Returns the set of ATOMIC_DW_FEATURE_* bits.
+ */
+ATOMIC_INLINE unsigned atomic_dw_features(void)
+{
+    static unsigned features;
+
+    unsigned f = __atomic_load_n(&features, __ATOMIC_RELAXED);
+    if (f == 0) {
+        f = ATOMIC_DW_FEATURE_PROBED;
+#if defined(__x86_64__)
+        unsigned a, b, c, d;
+        if (__get_cpuid(1, &a, &b, &c, &d)) {
+            if (c & bit_CMPXCHG16B) {
+                f |= ATOMIC_DW_FEATURE_CX16;
+                if (c & bit_AVX) {
+                    f |= ATOMIC_DW_FEATURE_AVX;
+                }
+            }
+        }
+#endif
+        __atomic_store_n(&features, f, __ATOMIC_RELAXED);
+    }
+    return f;
+}
+
+/**
+ *  Word view of the operands, allowed to alias any two-word structure.
+ */
+typedef uintptr_t __attribute__((may_alias)) atomic_dw_word_t;
+
+/**
+ *  Double-width compare-and-swap.
+ *
+ *  On x86-64 with CMPXCHG16B this is an inline `lock cmpxchg16b`.
+ *  Otherwise (pre-cx16 x86-64, other architectures) it falls back to the
+ *  generic __atomic builtin, which GCC turns into a libatomic call that
+ *  picks CASP/LDXP or a lock table at run time; link with -latomic.
+ *
+ *  @param  [in,out]    ptr         Target, aligned to sizeof(atomic_dw_t).
+ *  @param  [in,out]    expected    Expected value, updated on failure.
+ *  @param  [in]        desired     Value stored on success.
+ *  @return Returns true if @c ptr was updated, false if otherwise.
+ */
+ATOMIC_INLINE bool internal_atomic_dw_cas(void *ptr,
+                                         void *expected,
+                                         const void *desired)
+{
+#if defined(__x86_64__)
+    if (atomic_dw_features() & ATOMIC_DW_FEATURE_CX16) {
+        atomic_dw_word_t *e = (atomic_dw_word_t *)expected;
+        const atomic_dw_word_t *d = (const atomic_dw_word_t *)desired;
+        bool ok;
+        __asm__ __volatile__("lock cmpxchg16b %1"
+                             : "=@ccz"(ok), "+m"(*(atomic_dw_t *)ptr),
+                               "+a"(e[0]), "+d"(e[1])
+                             : "b"(d[0]), "c"(d[1])
+                             : "memory");
+        return ok;
+    }
+#endif
+    return __atomic_compare_exchange((atomic_dw_t *)ptr,
+                                     (atomic_dw_t *)expected,
+                                     (atomic_dw_t *)desired, false,
+                                     __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/**
+ *  Double-width atomic load.
+ *
+ *  Uses `movdqa` where AVX makes it atomic, `lock cmpxchg16b` with a
+ *  zero comparand where only CX16 exists, and the __atomic builtin
+ *  elsewhere.
+ *
+ *  @param  [in]    ptr Source, aligned to sizeof(atomic_dw_t).
+ *  @param  [out]   val Current value of @c ptr.
+ */
+ATOMIC_INLINE void internal_atomic_dw_load(void *ptr, void *val)
+{
+#if defined(__x86_64__)
+    unsigned f = atomic_dw_features();
+    if (f & ATOMIC_DW_FEATURE_AVX) {
+        __asm__ __volatile__("movdqa %1, %%xmm0\n\t"
+                             "movdqu %%xmm0, %0"
+                             : "=m"(*(atomic_dw_t *)val)
+                             : "m"(*(atomic_dw_t *)ptr)
+                             : "xmm0", "memory");
+        return;
+    }
+    if (f & ATOMIC_DW_FEATURE_CX16) {
+        atomic_dw_word_t *v = (atomic_dw_word_t *)val;
+        v[0] = v[1] = 0;
+        internal_atomic_dw_cas(ptr, val, val);
+        return;
+    }
+#endif
+    __atomic_load((atomic_dw_t *)ptr, (atomic_dw_t *)val, __ATOMIC_SEQ_CST);
+}
+
+/**
+ *  Double-width atomic store.
+ *
+ *  @param  [out]   ptr Target, aligned to sizeof(atomic_dw_t).
+ *  @param  [in]    val Value to store.
+ */
+ATOMIC_INLINE void internal_atomic_dw_store(void *ptr, const void *val)
+{
+#if defined(__x86_64__)
+    if (atomic_dw_features() & ATOMIC_DW_FEATURE_CX16) {
+        atomic_dw_t orig;
+        internal_atomic_dw_load(ptr, &orig);
+        while (!internal_atomic_dw_cas(ptr, &orig, val)) {
+        }
+        return;
+    }
+#endif
+    __atomic_store((atomic_dw_t *)ptr, (atomic_dw_t *)val, __ATOMIC_SEQ_CST);
+}
+
+/**
+ *  Typed wrappers of the primitives above for any two-word structure.
+ */
+#define ATOMIC_DW_CHECK(p)                                 \
+    _Static_assert(sizeof(*(p)) == sizeof(atomic_dw_t),    \
+                   "operand must be exactly double-width")
+
+#define atomic_dw_load(p)                                  \
+    ({                                                     \
+        ATOMIC_DW_CHECK(p);                                \
+        __typeof__(*(p)) __val;                            \
+        internal_atomic_dw_load((p), &__val);              \
+        __val;                                             \
+    })
+
+#define atomic_dw_store(p, v)                              \
+    ({                                                     \
+        ATOMIC_DW_CHECK(p);                                \
+        __typeof__(*(p)) __val = (v);                      \
+        internal_atomic_dw_store((p), &__val);             \
+    })
+
+#define atomic_dw_cas(p, e, d)                             \
+    ({                                                     \
+        ATOMIC_DW_CHECK(p);                                \
+        __typeof__(*(p)) __desired = (d);                  \
+        internal_atomic_dw_cas((p), (e), &__desired);      \
+    })
+
 #endif /* __ALGORITHMS_INTERNAL_ATOMIC_H__ */
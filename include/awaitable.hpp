@@ -0,0 +1,328 @@
+/** @file       awaitable.hpp
+ *  @brief      C++20 awaitables over the non-blocking containers.
+ *
+ *  Wraps a container in a channel whose push() and pop() are awaited:
+ *
+ *  @code
+ *  coro_queue<int> q(16);
+ *  co_await q.push(10);
+ *  int v = co_await q.pop();
+ *  @endcode
+ *
+ *  Both return a plain awaiter, not a coroutine, and try the container in
+ *  await_ready(); an operation that succeeds there completes without
+ *  suspending and without a coroutine frame. A failed one parks the
+ *  awaiting coroutine in an intrusive list, its node living in the
+ *  awaiter inside the suspended frame, and the operation that makes room
+ *  or a value hands it over and resumes the coroutine on the executor.
+ *
+ *  Awaiters count themselves in @c waiting before their last try, and
+ *  a push/pop that succeeds reads it afterwards, all seq_cst, so either
+ *  the waiter sees the item or the other side sees the waiter, as with
+ *  eventcount.h. While nobody waits the fast path adds only that load.
+ *
+ *  A suspended coroutine must not be destroyed, nor the channel while
+ *  coroutines wait on it.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __ALGORITHMS_INTERNAL_AWAITABLE_HPP__
+#define __ALGORITHMS_INTERNAL_AWAITABLE_HPP__
+
+#include <atomic>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <type_traits>
+
+namespace algorithms {
+
+/**
+ *  Resumes a coroutine right away, on the thread that woke it.
+ */
+struct inline_executor {
+    void operator()(std::coroutine_handle<> h) const
+    {
+        h.resume();
+    }
+};
+
+/**
+ *  For Ops: passes on @c ret of a container call that succeeded or failed
+ *  with @c again, its errno for full or empty, and throws
+ *  std::system_error for any other failure.
+ */
+inline int retry_on(int ret, int again)
+{
+    if ((ret != 0) && (errno != again)) {
+        throw std::system_error(errno, std::generic_category());
+    }
+    return ret;
+}
+
+/**
+ *  Channel of @c T over the container described by @c Ops:
+ *
+ *  @code
+ *  struct Ops {
+ *      using container_type = ...;
+ *      static int create(container_type *c, size_t value_bytes, size_t capacity);
+ *      static int destroy(container_type *c);
+ *      static int try_push(container_type *c, const void *value);
+ *      static int try_pop(container_type *c, void *value);
+ *  };
+ *  @endcode
+ *
+ *  try_push/try_pop return 0 on success and -1 while full/empty, without
+ *  blocking, and publish with seq_cst atomics (or end with a seq_cst
+ *  fence). Any other failure must throw, see retry_on(); the awaiting
+ *  coroutine then gets the exception instead of waiting for ever.
+ *  @c Executor is called with each coroutine to resume.
+ */
+template <typename Ops, typename T, typename Executor = inline_executor>
+class awaitable_channel {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "values are copied into the container byte-wise");
+
+    struct waiter {
+        waiter *next;
+        std::coroutine_handle<> handle;
+        void *value;
+        std::exception_ptr error;   /* set if wake() failed the operation. */
+    };
+
+    struct waiter_list {
+        waiter *head = nullptr;
+        waiter **tail = &head;
+
+        void push_back(waiter *w)
+        {
+            w->next = nullptr;
+            *tail = w;
+            tail = &w->next;
+        }
+
+        waiter *pop_front()
+        {
+            waiter *w = head;
+            head = w->next;
+            if (head == nullptr) {
+                tail = &head;
+            }
+            return w;
+        }
+    };
+
+public:
+    using container_type = typename Ops::container_type;
+
+    class pop_awaiter {
+    public:
+        explicit pop_awaiter(awaitable_channel &ch) : ch_(ch) {}
+
+        bool await_ready()
+        {
+            if (Ops::try_pop(&ch_.c_, &value_) != 0) {
+                return false;
+            }
+            ch_.wake();
+            return true;
+        }
+
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            {
+                std::lock_guard<std::mutex> lock(ch_.lock_);
+                ch_.waiting_.fetch_add(1);
+                int ret;
+                try {
+                    ret = Ops::try_pop(&ch_.c_, &value_);
+                } catch (...) {
+                    ch_.waiting_.fetch_sub(1);
+                    throw;
+                }
+                if (ret != 0) {
+                    w_.handle = h;
+                    w_.value = &value_;
+                    ch_.poppers_.push_back(&w_);
+                    return true;
+                }
+                ch_.waiting_.fetch_sub(1);
+            }
+            ch_.wake();
+            return false;
+        }
+
+        T await_resume()
+        {
+            if (w_.error) {
+                std::rethrow_exception(w_.error);
+            }
+            return value_;
+        }
+
+    private:
+        awaitable_channel &ch_;
+        waiter w_{};
+        T value_;
+    };
+
+    class push_awaiter {
+    public:
+        push_awaiter(awaitable_channel &ch, const T &value) : ch_(ch), value_(value) {}
+
+        bool await_ready()
+        {
+            if (Ops::try_push(&ch_.c_, &value_) != 0) {
+                return false;
+            }
+            ch_.wake();
+            return true;
+        }
+
+        bool await_suspend(std::coroutine_handle<> h)
+        {
+            {
+                std::lock_guard<std::mutex> lock(ch_.lock_);
+                ch_.waiting_.fetch_add(1);
+                int ret;
+                try {
+                    ret = Ops::try_push(&ch_.c_, &value_);
+                } catch (...) {
+                    ch_.waiting_.fetch_sub(1);
+                    throw;
+                }
+                if (ret != 0) {
+                    w_.handle = h;
+                    w_.value = &value_;
+                    ch_.pushers_.push_back(&w_);
+                    return true;
+                }
+                ch_.waiting_.fetch_sub(1);
+            }
+            ch_.wake();
+            return false;
+        }
+
+        void await_resume()
+        {
+            if (w_.error) {
+                std::rethrow_exception(w_.error);
+            }
+        }
+
+    private:
+        awaitable_channel &ch_;
+        waiter w_{};
+        T value_;
+    };
+
+    /**
+     *  @param  [in]    capacity    Most values held at once; what 0 means
+     *                              is up to the container.
+     *  @param  [in]    executor    Resumes the coroutines woken up.
+     */
+    explicit awaitable_channel(size_t capacity, Executor executor = Executor())
+        : executor_(std::move(executor))
+    {
+        if (Ops::create(&c_, sizeof(T), capacity) != 0) {
+            throw std::system_error(errno, std::generic_category());
+        }
+    }
+
+    ~awaitable_channel()
+    {
+        Ops::destroy(&c_);
+    }
+
+    awaitable_channel(const awaitable_channel &) = delete;
+    awaitable_channel &operator=(const awaitable_channel &) = delete;
+
+    pop_awaiter pop()
+    {
+        return pop_awaiter(*this);
+    }
+
+    push_awaiter push(const T &value)
+    {
+        return push_awaiter(*this, value);
+    }
+
+    /* the wrapped container, for its C API. */
+    container_type *native()
+    {
+        return &c_;
+    }
+
+private:
+    /**
+     *  Retries the first waiter of @c list with @c op, moving it to
+     *  @c ready once done, or failed: its awaiter then rethrows the error,
+     *  which is not the caller's.
+     *
+     *  @return Returns true if the waiter was moved.
+     */
+    template <typename Op>
+    bool retry_first(waiter_list &list, waiter_list &ready, Op op)
+    {
+        if (list.head == nullptr) {
+            return false;
+        }
+        try {
+            if (op(&c_, list.head->value) != 0) {
+                return false;
+            }
+        } catch (...) {
+            list.head->error = std::current_exception();
+        }
+        ready.push_back(list.pop_front());
+        waiting_.fetch_sub(1);
+        return true;
+    }
+
+    /**
+     *  After a push or pop: hands values and room over to the waiters,
+     *  in arrival order, until neither side can move. Never throws, as
+     *  the caller's own operation has succeeded.
+     */
+    void wake()
+    {
+        if (waiting_.load() == 0) {
+            return;
+        }
+
+        waiter_list ready;
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            bool moved = true;
+            while (moved) {
+                bool popped = retry_first(poppers_, ready, Ops::try_pop);
+                bool pushed = retry_first(pushers_, ready, Ops::try_push);
+                moved = popped || pushed;
+            }
+        }
+        while (ready.head != nullptr) {
+            /* the node goes away with the frame once resumed. */
+            waiter *w = ready.pop_front();
+            executor_(w->handle);
+        }
+    }
+
+    container_type c_;
+    Executor executor_;
+    std::atomic<size_t> waiting_{0};
+    std::mutex lock_;
+    waiter_list poppers_;
+    waiter_list pushers_;
+};
+
+} // namespace algorithms
+
+#endif /* __ALGORITHMS_INTERNAL_AWAITABLE_HPP__ */
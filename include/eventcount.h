@@ -0,0 +1,138 @@
+/** @file       eventcount.h
+ *  @brief      Futex-based event count.
+ *
+ *  Lets consumers of a lock-free structure sleep while it is empty
+ *  without adding anything but a load to the producer's fast path:
+ *
+ *  @code
+ *  consumer:                               producer:
+ *      key = eventcount_prepare(ec);           publish (seq_cst CAS);
+ *      if (try_take() succeeded) {             eventcount_notify(ec);
+ *          eventcount_cancel(ec);
+ *      } else {
+ *          eventcount_wait(ec, key, deadline);
+ *      }
+ *  @endcode
+ *
+ *  Both sides order their two accesses with seq_cst, so either the
+ *  producer sees the waiter or the consumer sees the item. A producer
+ *  that publishes with a plain store must issue a seq_cst fence before
+ *  eventcount_notify().
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __ALGORITHMS_INTERNAL_EVENTCOUNT_H__
+#define __ALGORITHMS_INTERNAL_EVENTCOUNT_H__
+
+#include <errno.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+struct eventcount {
+    uint32_t seq;       /* futex word, bumped by notifies that find waiters. */
+    uint32_t waiters;
+};
+
+#define EVENTCOUNT_INITIALIZER {0, 0}
+
+static inline void eventcount_init(struct eventcount *ec)
+{
+    __atomic_store_n(&ec->seq, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&ec->waiters, 0, __ATOMIC_RELAXED);
+}
+
+/**
+ *  Converts a poll(2)-style timeout into an absolute CLOCK_MONOTONIC
+ *  deadline for eventcount_wait().
+ *
+ *  @param  [in]    timeout_ms  Timeout in milliseconds, negative for none.
+ *  @param  [out]   ts          Storage for the deadline.
+ *  @return Returns @c ts, or NULL if @c timeout_ms is negative.
+ */
+static inline struct timespec *eventcount_deadline(int timeout_ms, struct timespec *ts)
+{
+    if (timeout_ms < 0) {
+        return NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += timeout_ms / 1000;
+    ts->tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec += 1;
+        ts->tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+/**
+ *  Announces a waiter. The caller must re-check its condition afterwards
+ *  and then either eventcount_cancel() or eventcount_wait().
+ *
+ *  @return Returns the key for eventcount_wait().
+ */
+static inline uint32_t eventcount_prepare(struct eventcount *ec)
+{
+    __atomic_fetch_add(&ec->waiters, 1, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&ec->seq, __ATOMIC_SEQ_CST);
+}
+
+static inline void eventcount_cancel(struct eventcount *ec)
+{
+    __atomic_fetch_sub(&ec->waiters, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ *  Sleeps until a notify after eventcount_prepare() returned @c key.
+ *
+ *  @param  [in,out]    ec          Event count.
+ *  @param  [in]        key         Key from eventcount_prepare().
+ *  @param  [in]        deadline    CLOCK_MONOTONIC deadline, NULL for none.
+ *  @return Returns zero if woken (possibly spuriously), -1 if the deadline
+ *          passed (errno is ETIMEDOUT).
+ */
+static inline int eventcount_wait(struct eventcount *ec, uint32_t key,
+                                  const struct timespec *deadline)
+{
+    long ret = syscall(SYS_futex, &ec->seq, FUTEX_WAIT_BITSET_PRIVATE, key,
+                       deadline, NULL, FUTEX_BITSET_MATCH_ANY);
+    int err = errno;
+    __atomic_fetch_sub(&ec->waiters, 1, __ATOMIC_RELAXED);
+    if ((ret != 0) && (err == ETIMEDOUT)) {
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ *  Wakes one waiter, if any. Costs a single load when nobody waits.
+ */
+static inline void eventcount_notify(struct eventcount *ec)
+{
+    if (__atomic_load_n(&ec->waiters, __ATOMIC_SEQ_CST) == 0) {
+        return;
+    }
+    __atomic_fetch_add(&ec->seq, 1, __ATOMIC_SEQ_CST);
+    syscall(SYS_futex, &ec->seq, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+/**
+ *  Wakes up to @c n waiters, e.g. after publishing @c n items at once.
+ */
+static inline void eventcount_notify_n(struct eventcount *ec, int n)
+{
+    if (__atomic_load_n(&ec->waiters, __ATOMIC_SEQ_CST) == 0) {
+        return;
+    }
+    __atomic_fetch_add(&ec->seq, 1, __ATOMIC_SEQ_CST);
+    syscall(SYS_futex, &ec->seq, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+#endif /* __ALGORITHMS_INTERNAL_EVENTCOUNT_H__ */
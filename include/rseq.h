@@ -0,0 +1,213 @@
+/** @file       rseq.h
+ *  @brief      Restartable sequences.
+ *
+ *  Per-CPU operations built on the rseq area that glibc (2.35 and later)
+ *  registers for every thread. The critical sections follow the x86-64
+ *  helpers of the Linux kernel selftests (tools/testing/selftests/rseq),
+ *  extended with a fence word so that another CPU can take exclusive
+ *  ownership of per-CPU data:
+ *
+ *  -# the remote side sets the fence word,
+ *  -# rseq_fence_cpu() restarts any critical section running on that CPU,
+ *  -# every critical section started afterwards sees the fence and aborts.
+ *
+ *  @sa         [M.Desnoyers,Restartable sequences,Linux kernel]
+ *              (https://www.kernel.org/doc/html/latest/userspace-api/rseq.html)
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __ALGORITHMS_INTERNAL_RSEQ_H__
+#define __ALGORITHMS_INTERNAL_RSEQ_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) && defined(__linux__) && __has_include(<sys/rseq.h>)
+#define RSEQ_IMPLEMENTED
+#endif
+
+#if defined(RSEQ_IMPLEMENTED)
+#include <unistd.h>
+#include <sys/rseq.h>
+#include <sys/syscall.h>
+#include <linux/membarrier.h>
+
+#define RSEQ_STR_1(x) #x
+#define RSEQ_STR(x) RSEQ_STR_1(x)
+
+/*
+ *  Emits the rseq_cs descriptor (start, commit, abort) and arms it.
+ *  Label 1 starts the section, 2 is the post-commit ip, 3 the descriptor
+ *  and 4 the abort handler, which must be preceded by RSEQ_SIG.
+ */
+#define RSEQ_ASM_BEGIN                                            \
+    ".pushsection __rseq_cs, \"aw\"\n\t"                          \
+    ".balign 32\n\t"                                              \
+    "3:\n\t"                                                      \
+    ".long 0x0, 0x0\n\t"                                          \
+    ".quad 1f, (2f - 1f), 4f\n\t"                                 \
+    ".popsection\n\t"                                             \
+    "leaq 3b(%%rip), %%rax\n\t"                                   \
+    "movq %%rax, %%fs:8(%[rseq_offset])\n\t"                      \
+    "1:\n\t"                                                      \
+    "cmpl %[cpu_id], %%fs:4(%[rseq_offset])\n\t"                  \
+    "jnz 4f\n\t"                                                  \
+    "cmpl $0, %[fence]\n\t"                                       \
+    "jnz 4f\n\t"
+
+#define RSEQ_ASM_END                                              \
+    "2:\n\t"                                                      \
+    ".pushsection __rseq_failure, \"ax\"\n\t"                     \
+    ".byte 0x0f, 0xb9, 0x3d\n\t"                                  \
+    ".long " RSEQ_STR(RSEQ_SIG) "\n\t"                            \
+    "4:\n\t"                                                      \
+    "jmp %l[abort]\n\t"                                           \
+    ".popsection\n\t"
+#endif
+
+/**
+ *  Checks once whether rseq is registered and remote CPUs can be fenced.
+ *
+ *  @return Returns true if the rseq_* operations are usable.
+ */
+static inline bool rseq_available(void)
+{
+#if defined(RSEQ_IMPLEMENTED)
+    static int available;   /* 0: unknown, 1: yes, -1: no */
+
+    int a = __atomic_load_n(&available, __ATOMIC_RELAXED);
+    if (a == 0) {
+        a = -1;
+        if ((__rseq_size != 0)
+            && (syscall(__NR_membarrier,
+                        MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED_RSEQ,
+                        0, 0) == 0)) {
+            a = 1;
+        }
+        __atomic_store_n(&available, a, __ATOMIC_RELAXED);
+    }
+    return a > 0;
+#else
+    return false;
+#endif
+}
+
+/**
+ *  Returns the CPU the calling thread is running on.
+ *
+ *  The value may be stale by the time it is used; the critical sections
+ *  below verify it and abort if the thread has migrated.
+ */
+static inline int rseq_current_cpu(void)
+{
+#if defined(RSEQ_IMPLEMENTED)
+    struct rseq *rs = (struct rseq *)((uintptr_t)__builtin_thread_pointer()
+                                      + __rseq_offset);
+    return (int)__atomic_load_n(&rs->cpu_id_start, __ATOMIC_RELAXED);
+#else
+    return 0;
+#endif
+}
+
+/**
+ *  Restarts every critical section in flight on @c cpu, so that the
+ *  caller owns data guarded by a fence word it has just set.
+ *
+ *  @return Returns zero if succeed, -1 if failed.
+ */
+static inline int rseq_fence_cpu(int cpu)
+{
+#if defined(RSEQ_IMPLEMENTED)
+    return (int)syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED_RSEQ,
+                        MEMBARRIER_CMD_FLAG_CPU, cpu);
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
+
+/**
+ *  On @c cpu: if *v == expect, stores *v = newv.
+ *
+ *  @return Returns 0 if stored, 1 if *v != expect, -1 if aborted
+ *          (migrated, preempted, signalled or fenced).
+ */
+static inline int rseq_cmpeqv_storev(intptr_t *v, intptr_t expect,
+                                     intptr_t newv, int cpu,
+                                     const uint32_t *fence)
+{
+#if defined(RSEQ_IMPLEMENTED)
+    __asm__ __volatile__ goto (
+        RSEQ_ASM_BEGIN
+        "cmpq %[v], %[expect]\n\t"
+        "jnz %l[cmpfail]\n\t"
+        "movq %[newv], %[v]\n\t"
+        RSEQ_ASM_END
+        :
+        : [cpu_id] "r"(cpu),
+          [rseq_offset] "r"(__rseq_offset),
+          [fence] "m"(*fence),
+          [v] "m"(*v),
+          [expect] "r"(expect),
+          [newv] "r"(newv)
+        : "memory", "cc", "rax"
+        : abort, cmpfail);
+    return 0;
+abort:
+    return -1;
+cmpfail:
+    return 1;
+#else
+    (void)v; (void)expect; (void)newv; (void)cpu; (void)fence;
+    return -1;
+#endif
+}
+
+/**
+ *  On @c cpu: if *v != expectnot, loads *load = *v and stores
+ *  *v = *(*v + voffp). This pops the head of a singly linked list whose
+ *  link sits @c voffp bytes into each element.
+ *
+ *  @return Returns 0 if popped, 1 if *v == expectnot, -1 if aborted.
+ */
+static inline int rseq_cmpnev_storeoffp_load(intptr_t *v, intptr_t expectnot,
+                                             long voffp, intptr_t *load,
+                                             int cpu, const uint32_t *fence)
+{
+#if defined(RSEQ_IMPLEMENTED)
+    __asm__ __volatile__ goto (
+        RSEQ_ASM_BEGIN
+        "movq %[v], %%rbx\n\t"
+        "cmpq %%rbx, %[expectnot]\n\t"
+        "je %l[cmpfail]\n\t"
+        "movq %%rbx, %[load]\n\t"
+        "addq %[voffp], %%rbx\n\t"
+        "movq (%%rbx), %%rbx\n\t"
+        "movq %%rbx, %[v]\n\t"
+        RSEQ_ASM_END
+        :
+        : [cpu_id] "r"(cpu),
+          [rseq_offset] "r"(__rseq_offset),
+          [fence] "m"(*fence),
+          [v] "m"(*v),
+          [expectnot] "r"(expectnot),
+          [voffp] "er"(voffp),
+          [load] "m"(*load)
+        : "memory", "cc", "rax", "rbx"
+        : abort, cmpfail);
+    return 0;
+abort:
+    return -1;
+cmpfail:
+    return 1;
+#else
+    (void)v; (void)expectnot; (void)voffp; (void)load; (void)cpu; (void)fence;
+    return -1;
+#endif
+}
+
+#endif /* __ALGORITHMS_INTERNAL_RSEQ_H__ */
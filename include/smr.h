@@ -0,0 +1,488 @@
+/** @file       smr.h
+ *  @brief      Safe memory reclamation.
+ *
+ *  Hazard pointers and epoch-based reclamation behind one interface, so
+ *  that a lock-free structure can defer freeing the nodes it unlinks
+ *  until no concurrent operation can still be reading them:
+ *
+ *  @code
+ *  struct smr_record *r = smr_enter(&d);
+ *  do {
+ *      node = smr_protect(&d, r, 0, atomic_load(&head));
+ *  } while (node != atomic_load(&head));      (validate after publishing)
+ *  ... unlink node ...
+ *  smr_retire(&d, r, node);
+ *  smr_leave(&d, r);
+ *  @endcode
+ *
+ *  An operation holds a record between smr_enter() and smr_leave(). Each
+ *  record keeps the nodes retired through it and scans them in batches of
+ *  SMR_RETIRE_BATCH, backing off while nodes stay pinned. A thread-local
+ *  hint hands a thread the record it used last, so records and their
+ *  retire lists behave as per-thread ones, yet nothing is lost when a
+ *  thread exits. Operations must not nest.
+ *
+ *  Records are added as more operations overlap and kept until
+ *  smr_destroy(), in blocks of SMR_BLOCK_RECORDS chained from the domain,
+ *  so there is no limit on concurrent operations. The first block is part
+ *  of the domain.
+ *
+ *  - SMR_HAZARD: smr_protect() publishes the pointer; a scan frees the
+ *    nodes that no record publishes. Bounded garbage; the fence each
+ *    protect needs is moved into the scan with membarrier(2) if possible.
+ *  - SMR_EPOCH: smr_enter() publishes the global epoch; a scan advances it
+ *    once every busy record has caught up and frees the nodes retired two
+ *    epochs ago. Protecting is free, but a stalled operation holds back
+ *    all reclamation.
+ *
+ *  @sa         [MM.Michael,Hazard Pointers: Safe Memory Reclamation for
+ *              Lock-Free Objects,IEEE TPDS 2004]
+ *  @sa         [K.Fraser,Practical lock-freedom,2004]
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __ALGORITHMS_INTERNAL_SMR_H__
+#define __ALGORITHMS_INTERNAL_SMR_H__
+
+#include <errno.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/membarrier.h>
+
+#include "atomic.h"
+
+#define SMR_HAZARD 0
+#define SMR_EPOCH 1
+
+#define SMR_BLOCK_RECORDS 64
+#define SMR_HAZARDS 4           /* hazard pointers per record. */
+#define SMR_RETIRE_BATCH 64
+
+struct smr_retired {
+    void *ptr;
+    uint64_t epoch;
+};
+
+/*
+ *  Record state: 0 while free, SMR_BUSY while held outside any epoch and
+ *  SMR_IN_EPOCH(e) while an operation runs in epoch e. Taking a record
+ *  and publishing its epoch is then a single CAS, whose full barrier also
+ *  orders the publication before the operation's loads.
+ */
+#define SMR_BUSY 1
+#define SMR_IN_EPOCH(e) ((((e) + 1) << 1) | SMR_BUSY)
+#define SMR_EPOCH_OF(s) (((s) >> 1) - 1)
+
+struct smr_record {
+    alignas(CACHE_LINE_BYTES) uint64_t state;
+    void *hazard[SMR_HAZARDS];
+    size_t nretired;
+    size_t capacity;
+    size_t next_scan;
+    struct smr_retired *retired;
+    void **hazards;             /* scan scratch, nhazards_max entries. */
+    size_t nhazards_max;
+};
+
+struct smr_block {
+    struct smr_record *records[SMR_BLOCK_RECORDS];
+    struct smr_block *next;
+};
+
+struct smr_domain {
+    int scheme;
+    uint32_t nrecords;          /* records[0, nrecords) and their blocks exist. */
+    struct smr_block records;
+    void (*reclaim)(void *ptr, void *arg);
+    void *arg;
+    alignas(CACHE_LINE_BYTES) uint64_t epoch;
+};
+
+/**
+ *  Initializes @c d.
+ *
+ *  @param  [out]   d       Domain.
+ *  @param  [in]    scheme  SMR_HAZARD or SMR_EPOCH.
+ *  @param  [in]    reclaim Called for each node once it is safe to free.
+ *  @param  [in]    arg     Passed to @c reclaim.
+ *  @return Returns zero if succeed, -1 if failed.
+ */
+static inline int smr_init(struct smr_domain *d, int scheme,
+                           void (*reclaim)(void *ptr, void *arg), void *arg)
+{
+    if ((d == NULL) || (reclaim == NULL)
+        || ((scheme != SMR_HAZARD) && (scheme != SMR_EPOCH))) {
+        errno = EINVAL;
+        return -1;
+    }
+    memset(d, 0, sizeof(*d));
+    d->scheme = scheme;
+    d->reclaim = reclaim;
+    d->arg = arg;
+    return 0;
+}
+
+/**
+ *  Returns the slot of record @c k, adding the blocks up to it if
+ *  @c grow, else NULL if they do not exist yet.
+ */
+static inline struct smr_record **smr_slot(struct smr_domain *d, uint32_t k, bool grow)
+{
+    struct smr_block *b = &d->records;
+    for (uint32_t i = k / SMR_BLOCK_RECORDS; i > 0; --i) {
+        struct smr_block *next = __atomic_load_n(&b->next, __ATOMIC_ACQUIRE);
+        if ((next == NULL) && grow) {
+            struct smr_block *mine = (struct smr_block *)calloc(1, sizeof(*mine));
+            if (mine == NULL) {
+                return NULL;
+            }
+            if (__atomic_compare_exchange_n(&b->next, &next, mine, false,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                next = mine;
+            } else {
+                free(mine);
+            }
+        }
+        if (next == NULL) {
+            return NULL;
+        }
+        b = next;
+    }
+    return &b->records[k % SMR_BLOCK_RECORDS];
+}
+
+/**
+ *  Returns record @c k of a walk over k = 0, 1, ... below a loaded
+ *  nrecords, @c b starting at the domain's first block.
+ */
+static inline struct smr_record *smr_record_next(struct smr_block **b, uint32_t k)
+{
+    if ((k > 0) && ((k % SMR_BLOCK_RECORDS) == 0)) {
+        *b = __atomic_load_n(&(*b)->next, __ATOMIC_ACQUIRE);
+    }
+    return (*b)->records[k % SMR_BLOCK_RECORDS];
+}
+
+/**
+ *  Reclaims every retired node and frees the records. No operation may
+ *  be in flight.
+ */
+static inline void smr_destroy(struct smr_domain *d)
+{
+    struct smr_block *b = &d->records;
+    for (uint32_t k = 0; k < d->nrecords; ++k) {
+        struct smr_record *r = smr_record_next(&b, k);
+        for (size_t i = 0; i < r->nretired; ++i) {
+            d->reclaim(r->retired[i].ptr, d->arg);
+        }
+        free(r->retired);
+        free(r->hazards);
+        free(r);
+    }
+    b = d->records.next;
+    while (b != NULL) {
+        struct smr_block *next = b->next;
+        free(b);
+        b = next;
+    }
+    memset(&d->records, 0, sizeof(d->records));
+    d->nrecords = 0;
+}
+
+/**
+ *  Checks once whether membarrier(2) can stand in for the fence of
+ *  smr_protect(), moving its cost to the (batched) hazard scans.
+ */
+static inline bool smr_membarrier_available(void)
+{
+    static int available;   /* 0: unknown, 1: yes, -1: no */
+
+    int a = __atomic_load_n(&available, __ATOMIC_RELAXED);
+    if (a == 0) {
+        a = (syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED,
+                     0, 0) == 0) ? 1 : -1;
+        __atomic_store_n(&available, a, __ATOMIC_RELAXED);
+    }
+    return a > 0;
+}
+
+static inline bool smr_try_take(struct smr_record *r, uint64_t state)
+{
+    uint64_t idle = 0;
+    return (__atomic_load_n(&r->state, __ATOMIC_RELAXED) == 0)
+           && __atomic_compare_exchange_n(&r->state, &idle, state, false,
+                                          __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+/**
+ *  Takes a free record, preferring the one this thread used last, and
+ *  sets its state to @c state.
+ *
+ *  @return Returns the record, NULL if none could be allocated.
+ */
+static inline struct smr_record *smr_acquire(struct smr_domain *d, uint64_t state)
+{
+    static __thread uint32_t hint;
+
+    while (true) {
+        uint32_t n = __atomic_load_n(&d->nrecords, __ATOMIC_ACQUIRE);
+        if (hint < n) {
+            struct smr_record *r = *smr_slot(d, hint, false);
+            if (smr_try_take(r, state)) {
+                return r;
+            }
+        }
+        struct smr_block *b = &d->records;
+        for (uint32_t k = 0; k < n; ++k) {
+            struct smr_record *r = smr_record_next(&b, k);
+            if (smr_try_take(r, state)) {
+                hint = k;
+                return r;
+            }
+        }
+
+        /* every record is busy: add one at index n. */
+        struct smr_record **slot = smr_slot(d, n, true);
+        struct smr_record *mine = NULL;
+        if (slot != NULL) {
+            mine = (struct smr_record *)aligned_alloc(alignof(struct smr_record),
+                                                      sizeof(*mine));
+        }
+        if (mine == NULL) {
+            if (n == 0) {
+                errno = ENOMEM;
+                return NULL;
+            }
+            cpu_relax();
+            continue;
+        }
+        memset(mine, 0, sizeof(*mine));
+        mine->state = state;
+        mine->next_scan = SMR_RETIRE_BATCH;
+        struct smr_record *none = NULL;
+        bool added = __atomic_compare_exchange_n(slot, &none, mine, false,
+                                                 __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+        if (!added) {
+            free(mine);
+        }
+        __atomic_compare_exchange_n(&d->nrecords, &n, n + 1, false,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+        if (added) {
+            hint = n;
+            return mine;
+        }
+    }
+}
+
+static inline void smr_release(struct smr_record *r)
+{
+    __atomic_store_n(&r->state, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ *  Starts an operation.
+ *
+ *  @return Returns the record to pass to the other calls, NULL if failed.
+ */
+static inline struct smr_record *smr_enter(struct smr_domain *d)
+{
+    if (d->scheme == SMR_HAZARD) {
+        return smr_acquire(d, SMR_BUSY);
+    }
+
+    uint64_t e = __atomic_load_n(&d->epoch, __ATOMIC_RELAXED);
+    struct smr_record *r = smr_acquire(d, SMR_IN_EPOCH(e));
+    if (r != NULL) {
+        /* the epoch may have moved on before the record was published. */
+        uint64_t g;
+        while ((g = __atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST)) != e) {
+            __atomic_store_n(&r->state, SMR_IN_EPOCH(g), __ATOMIC_SEQ_CST);
+            e = g;
+        }
+    }
+    return r;
+}
+
+/**
+ *  Ends an operation, dropping its hazards or leaving its epoch.
+ */
+static inline void smr_leave(struct smr_domain *d, struct smr_record *r)
+{
+    if (d->scheme == SMR_HAZARD) {
+        for (int i = 0; i < SMR_HAZARDS; ++i) {
+            if (__atomic_load_n(&r->hazard[i], __ATOMIC_RELAXED) != NULL) {
+                __atomic_store_n(&r->hazard[i], NULL, __ATOMIC_RELEASE);
+            }
+        }
+    }
+    smr_release(r);
+}
+
+/**
+ *  Protects @c ptr in hazard slot @c slot. The caller must re-read the
+ *  location @c ptr came from and retry if it changed; only then is
+ *  @c ptr safe to dereference until smr_leave() or the slot is reused.
+ *
+ *  @return Returns @c ptr.
+ */
+static inline void *smr_protect(struct smr_domain *d, struct smr_record *r,
+                                int slot, void *ptr)
+{
+    if (d->scheme == SMR_HAZARD) {
+        if (smr_membarrier_available()) {
+            /* the scan's membarrier supplies the fence. */
+            __atomic_store_n(&r->hazard[slot], ptr, __ATOMIC_RELAXED);
+            __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        } else {
+            __atomic_store_n(&r->hazard[slot], ptr, __ATOMIC_SEQ_CST);
+        }
+    }
+    return ptr;
+}
+
+/**
+ *  Advances the global epoch if every busy record has entered it.
+ */
+static inline void smr_try_advance(struct smr_domain *d)
+{
+    uint64_t g = __atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST);
+    uint32_t n = __atomic_load_n(&d->nrecords, __ATOMIC_ACQUIRE);
+    struct smr_block *b = &d->records;
+    for (uint32_t k = 0; k < n; ++k) {
+        uint64_t state = __atomic_load_n(&smr_record_next(&b, k)->state, __ATOMIC_SEQ_CST);
+        if ((state > SMR_BUSY) && (SMR_EPOCH_OF(state) != g)) {
+            return;
+        }
+    }
+    __atomic_compare_exchange_n(&d->epoch, &g, g + 1, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+/**
+ *  Reclaims the nodes retired through @c r that are no longer reachable
+ *  by any operation.
+ *
+ *  @return Returns the number of nodes reclaimed.
+ */
+static inline size_t smr_scan(struct smr_domain *d, struct smr_record *r)
+{
+    size_t kept = 0, n = r->nretired;
+
+    if (d->scheme == SMR_HAZARD) {
+        size_t nhazards = 0;
+
+        if (!smr_membarrier_available()
+            || (syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0) != 0)) {
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        }
+        uint32_t nrecords = __atomic_load_n(&d->nrecords, __ATOMIC_ACQUIRE);
+        if ((size_t)nrecords * SMR_HAZARDS > r->nhazards_max) {
+            size_t max = (size_t)nrecords * SMR_HAZARDS * 2;
+            void **grown = (void **)realloc(r->hazards, sizeof(*grown) * max);
+            if (grown == NULL) {
+                return 0;   /* keep everything until a later scan. */
+            }
+            r->hazards = grown;
+            r->nhazards_max = max;
+        }
+        void **hazards = r->hazards;
+        struct smr_block *b = &d->records;
+        for (uint32_t k = 0; k < nrecords; ++k) {
+            struct smr_record *other = smr_record_next(&b, k);
+            for (int i = 0; i < SMR_HAZARDS; ++i) {
+                void *p = __atomic_load_n(&other->hazard[i], __ATOMIC_SEQ_CST);
+                if (p != NULL) {
+                    hazards[nhazards++] = p;
+                }
+            }
+        }
+        for (size_t i = 0; i < n; ++i) {
+            bool hazarded = false;
+            for (size_t h = 0; (h < nhazards) && !hazarded; ++h) {
+                hazarded = (hazards[h] == r->retired[i].ptr);
+            }
+            if (hazarded) {
+                r->retired[kept++] = r->retired[i];
+            } else {
+                d->reclaim(r->retired[i].ptr, d->arg);
+            }
+        }
+    } else {
+        smr_try_advance(d);
+        uint64_t g = __atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST);
+        for (size_t i = 0; i < n; ++i) {
+            if (r->retired[i].epoch + 2 <= g) {
+                d->reclaim(r->retired[i].ptr, d->arg);
+            } else {
+                r->retired[kept++] = r->retired[i];
+            }
+        }
+    }
+
+    /* back off geometrically while nodes stay pinned. */
+    r->nretired = kept;
+    r->next_scan = kept + ((kept > SMR_RETIRE_BATCH) ? kept : SMR_RETIRE_BATCH);
+    return n - kept;
+}
+
+/**
+ *  Hands @c ptr, already unlinked, over for reclamation. Scans once
+ *  enough nodes are pending: SMR_RETIRE_BATCH, or as many as the last
+ *  scan kept, more than it left.
+ */
+static inline void smr_retire(struct smr_domain *d, struct smr_record *r, void *ptr)
+{
+    while (r->nretired == r->capacity) {
+        size_t capacity = (r->capacity == 0) ? SMR_RETIRE_BATCH * 2 : r->capacity * 2;
+        struct smr_retired *retired =
+            (struct smr_retired *)realloc(r->retired, sizeof(*retired) * capacity);
+        if (retired != NULL) {
+            r->retired = retired;
+            r->capacity = capacity;
+        } else if (smr_scan(d, r) == 0) {
+            cpu_relax();
+        }
+    }
+    r->retired[r->nretired].ptr = ptr;
+    r->retired[r->nretired].epoch = __atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST);
+    r->nretired++;
+
+    if (r->nretired >= r->next_scan) {
+        smr_scan(d, r);
+    }
+}
+
+/**
+ *  Scans every record not held by an operation, e.g. when an allocator
+ *  has run dry. Must not be called between smr_enter() and smr_leave().
+ *
+ *  @return Returns the number of nodes reclaimed.
+ */
+static inline size_t smr_collect(struct smr_domain *d)
+{
+    size_t freed = 0;
+    /* epochs need two advances before the newest nodes can go. */
+    for (int round = 0; round < ((d->scheme == SMR_EPOCH) ? 3 : 1); ++round) {
+        uint32_t n = __atomic_load_n(&d->nrecords, __ATOMIC_ACQUIRE);
+        struct smr_block *b = &d->records;
+        for (uint32_t k = 0; k < n; ++k) {
+            struct smr_record *r = smr_record_next(&b, k);
+            if (smr_try_take(r, SMR_BUSY)) {
+                freed += smr_scan(d, r);
+                smr_release(r);
+            }
+        }
+    }
+    return freed;
+}
+
+#endif /* __ALGORITHMS_INTERNAL_SMR_H__ */
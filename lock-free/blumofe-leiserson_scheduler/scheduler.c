@@ -0,0 +1,385 @@
+/** @file       scheduler.c
+ *  @brief      Work-stealing fork-join scheduler implementation.
+ *
+ *  Each worker owns a Chase-Lev deque: spawn pushes the task at its
+ *  bottom and the worker pops from there, so a worker runs its own tasks
+ *  depth first without contention. A worker out of tasks steals from the
+ *  top of the deques of workers picked at random, which yields the
+ *  oldest, and so largest, pieces of work.
+ *
+ *  A worker that finds nothing after a while parks on a futex event
+ *  count. Spawn publishes with a plain store, then a seq_cst fence and
+ *  eventcount_notify(), a load of the waiter count while nobody parks.
+ *  A parking worker re-checks every deque after announcing itself, so
+ *  one of the two sees the other.
+ *
+ *  Tasks come from a lock-free memory pool, since they are freed by the
+ *  worker that ran them rather than the one that spawned them. A spawn
+ *  that finds the pool empty runs the task in place, as does one whose
+ *  deque cannot grow.
+ *
+ *  scheduler_sync() runs other tasks, its own first, until the group is
+ *  done instead of blocking, so a sync never idles a worker while there
+ *  is work, at the price of a deeper stack.
+ *
+ *  @sa         [R.D.Blumofe&C.E.Leiserson,Scheduling Multithreaded
+ *              Computations by Work Stealing,JACM 1999]
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "aux.h"
+#include "debug.h"
+#include "atomic.h"
+#include "scheduler.h"
+
+/* failed rounds of steals before a worker parks. */
+#define SCHEDULER_IDLE_SPINS 64
+
+struct task {
+    void (*func)(void *);
+    void *arg;
+    task_group_t *group;
+};
+
+struct scheduler_worker {
+    alignas(CACHE_LINE_BYTES) wsdeque_t deque;
+    scheduler_t *sched;
+    uint64_t seed;
+    pthread_t thread;
+};
+
+/* the worker the calling thread is, NULL for none. */
+static _Thread_local struct scheduler_worker *current;
+
+static inline struct scheduler_worker *current_of(scheduler_t *self)
+{
+    return ((current != NULL) && (current->sched == self)) ? current : NULL;
+}
+
+static inline uint64_t xorshift(uint64_t *seed)
+{
+    uint64_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *seed = x;
+}
+
+/**
+ *  Takes a task from the own deque, else steals one from another worker.
+ */
+static bool find_task(struct scheduler_worker *w, struct task **t)
+{
+    if (wsdeque_pop(&w->deque, t) == 0) {
+        return true;
+    }
+
+    scheduler_t *self = w->sched;
+    size_t n = self->nworkers;
+    if (n < 2) {
+        return false;
+    }
+    size_t start = (size_t)(xorshift(&w->seed) % n);
+    for (size_t i = 0; i < n; ++i) {
+        struct scheduler_worker *victim = &self->workers[(start + i) % n];
+        if (victim == w) {
+            continue;
+        }
+        /* a lost race means work is left; one retry per victim. */
+        if ((wsdeque_steal(&victim->deque, t) == 0)
+            || ((errno == EAGAIN) && (wsdeque_steal(&victim->deque, t) == 0))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool has_work(scheduler_t *self)
+{
+    for (size_t i = 0; i < self->nworkers; ++i) {
+        if (wsdeque_size(&self->workers[i].deque) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void run_task(scheduler_t *self, struct task *t)
+{
+    task_group_t *group = t->group;
+
+    t->func(t->arg);
+    mempool_free(&self->tasks, t);
+    /* the group may be gone as soon as it reads 0. */
+    atomic_fetch_sub_explicit(&group->pending, 1, memory_order_release);
+}
+
+static void *worker_main(void *arg)
+{
+    struct scheduler_worker *w = (struct scheduler_worker *)arg;
+    scheduler_t *self = w->sched;
+    int spins = 0;
+
+    current = w;
+    while (!atomic_load_explicit(&self->stop, memory_order_relaxed)) {
+        struct task *t;
+        if (find_task(w, &t)) {
+            run_task(self, t);
+            spins = 0;
+            continue;
+        }
+        if (spins++ < SCHEDULER_IDLE_SPINS) {
+            cpu_relax();
+            continue;
+        }
+
+        uint32_t key = eventcount_prepare(&self->idle);
+        if (atomic_load(&self->stop) || has_work(self)) {
+            eventcount_cancel(&self->idle);
+        } else {
+            eventcount_wait(&self->idle, key, NULL);
+        }
+        spins = 0;
+    }
+    current = NULL;
+
+    return NULL;
+}
+
+int scheduler_create(scheduler_t *s, size_t workers, size_t max_tasks)
+{
+    if ((s == NULL) || (workers == 0) || (max_tasks == 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (workers > SIZE_MAX / sizeof(*s->workers)) {
+        errno = ENOMEM;
+        return -1;
+    }
+    s->workers = aligned_alloc(alignof(struct scheduler_worker),
+                               sizeof(*s->workers) * workers);
+    if (s->workers == NULL) {
+        return -1;
+    }
+    memset(s->workers, 0, sizeof(*s->workers) * workers);
+    s->nworkers = 0;
+    atomic_store(&s->stop, false);
+    eventcount_init(&s->idle);
+    pthread_mutex_init(&s->caller, NULL);
+    if (mempool_create(&s->tasks, sizeof(struct task), max_tasks) != 0) {
+        goto free_workers;
+    }
+
+    for (size_t i = 0; i < workers; ++i) {
+        struct scheduler_worker *w = &s->workers[i];
+        if (wsdeque_create(&w->deque, sizeof(struct task *), 64) != 0) {
+            goto destroy;
+        }
+        w->sched = s;
+        w->seed = 0x9e3779b97f4a7c15ULL * (i + 1);
+        s->nworkers = i + 1;
+    }
+    /* worker 0 is lent to scheduler_run() callers. */
+    for (size_t i = 1; i < workers; ++i) {
+        int err = pthread_create(&s->workers[i].thread, NULL, worker_main, &s->workers[i]);
+        if (err != 0) {
+            ERROR("failed to start worker %zu: %s", i, strerror(err));
+            for (size_t j = i; j < workers; ++j) {
+                wsdeque_destroy(&s->workers[j].deque);
+            }
+            s->nworkers = i;
+            scheduler_destroy(s);
+            errno = err;
+            return -1;
+        }
+    }
+
+    return 0;
+
+destroy:
+    for (size_t i = 0; i < s->nworkers; ++i) {
+        wsdeque_destroy(&s->workers[i].deque);
+    }
+    mempool_destroy(&s->tasks);
+free_workers:
+    pthread_mutex_destroy(&s->caller);
+    free(s->workers);
+    s->workers = NULL;
+    return -1;
+}
+
+int scheduler_destroy(scheduler_t *s)
+{
+    if ((s == NULL) || (s->workers == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    atomic_store(&s->stop, true);
+    eventcount_notify_n(&s->idle, INT_MAX);
+    for (size_t i = 1; i < s->nworkers; ++i) {
+        pthread_join(s->workers[i].thread, NULL);
+    }
+    for (size_t i = 0; i < s->nworkers; ++i) {
+        wsdeque_destroy(&s->workers[i].deque);
+    }
+    mempool_destroy(&s->tasks);
+    pthread_mutex_destroy(&s->caller);
+    free(s->workers);
+    s->workers = NULL;
+
+    return 0;
+}
+
+int scheduler_run(scheduler_t *s, void (*func)(void *), void *arg)
+{
+    if ((s == NULL) || (s->workers == NULL) || (func == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (current_of(s) != NULL) {
+        func(arg);
+        return 0;
+    }
+
+    pthread_mutex_lock(&s->caller);
+    struct scheduler_worker *prev = current;
+    current = &s->workers[0];
+    func(arg);
+    current = prev;
+    pthread_mutex_unlock(&s->caller);
+
+    return 0;
+}
+
+int scheduler_spawn(scheduler_t *s, task_group_t *g, void (*func)(void *), void *arg)
+{
+    if ((s == NULL) || (g == NULL) || (func == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct scheduler_worker *w = current_of(s);
+    if (w == NULL) {
+        errno = EPERM;
+        return -1;
+    }
+
+    struct task *t = mempool_alloc(&s->tasks);
+    if (t == NULL) {
+        func(arg);
+        return 0;
+    }
+    t->func = func;
+    t->arg = arg;
+    t->group = g;
+    atomic_fetch_add_explicit(&g->pending, 1, memory_order_relaxed);
+    if (wsdeque_push(&w->deque, &t) != 0) {
+        atomic_fetch_sub_explicit(&g->pending, 1, memory_order_relaxed);
+        mempool_free(&s->tasks, t);
+        func(arg);
+        return 0;
+    }
+    atomic_thread_fence(memory_order_seq_cst);
+    eventcount_notify(&s->idle);
+
+    return 0;
+}
+
+int scheduler_sync(scheduler_t *s, task_group_t *g)
+{
+    if ((s == NULL) || (g == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+    struct scheduler_worker *w = current_of(s);
+    if (w == NULL) {
+        errno = EPERM;
+        return -1;
+    }
+
+    while (atomic_load_explicit(&g->pending, memory_order_acquire) != 0) {
+        struct task *t;
+        if (find_task(w, &t)) {
+            run_task(s, t);
+        } else {
+            /* the rest is running elsewhere. */
+            sched_yield();
+        }
+    }
+
+    return 0;
+}
+
+struct range {
+    scheduler_t *sched;
+    size_t begin;
+    size_t end;
+    size_t grain;
+    void (*body)(void *, size_t);
+    void *arg;
+};
+
+static void for_range(void *arg)
+{
+    struct range *r = (struct range *)arg;
+
+    if (r->end - r->begin <= r->grain) {
+        for (size_t i = r->begin; i < r->end; ++i) {
+            r->body(r->arg, i);
+        }
+        return;
+    }
+
+    task_group_t g = TASK_GROUP_INITIALIZER;
+    size_t mid = r->begin + ((r->end - r->begin) / 2);
+    struct range upper = *r, lower = *r;
+    upper.begin = mid;
+    lower.end = mid;
+    scheduler_spawn(r->sched, &g, for_range, &upper);
+    for_range(&lower);
+    scheduler_sync(r->sched, &g);
+}
+
+int scheduler_parallel_for(scheduler_t *s, size_t begin, size_t end, size_t grain,
+                           void (*body)(void *, size_t), void *arg)
+{
+    if ((s == NULL) || (s->workers == NULL) || (body == NULL) || (begin > end)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (grain == 0) {
+        grain = (end - begin) / (s->nworkers * 8);
+        if (grain == 0) {
+            grain = 1;
+        }
+    }
+    struct range r = {
+        .sched = s,
+        .begin = begin,
+        .end = end,
+        .grain = grain,
+        .body = body,
+        .arg = arg,
+    };
+    return scheduler_run(s, for_range, &r);
+}
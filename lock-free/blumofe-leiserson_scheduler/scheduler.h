@@ -0,0 +1,77 @@
+/** @file       scheduler.h
+ *  @brief      Work-stealing fork-join scheduler implementation.
+ *
+ *  @sa         [R.D.Blumofe&C.E.Leiserson,Scheduling Multithreaded
+ *              Computations by Work Stealing,JACM 1999]
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __ALGORITHMS_INTERNAL_SCHEDULER_H__
+#define __ALGORITHMS_INTERNAL_SCHEDULER_H__
+
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "eventcount.h"
+#include "mempool.h"
+#include "wsdeque.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct scheduler_worker;
+
+typedef struct scheduler {
+    struct scheduler_worker *workers;
+    size_t nworkers;
+    mpool_t tasks;                  /* spawned tasks, from any worker. */
+    pthread_mutex_t caller;         /* one outside thread at a time is worker 0. */
+    alignas(CACHE_LINE_BYTES) struct eventcount idle;  /* parked workers. */
+    alignas(CACHE_LINE_BYTES) bool stop;
+} scheduler_t;
+
+/**
+ *  Tasks spawned into a group are waited for together by scheduler_sync().
+ */
+typedef struct task_group {
+    size_t pending;
+} task_group_t;
+
+#define TASK_GROUP_INITIALIZER {0}
+
+/*
+ *  Starts @c workers - 1 threads as workers 1 and up; worker 0 is lent
+ *  to the thread calling scheduler_run(). At most @c max_tasks spawned tasks wait at once,
+ *  spawns beyond that run in place.
+ */
+int scheduler_create(scheduler_t *s, size_t workers, size_t max_tasks);
+int scheduler_destroy(scheduler_t *s);
+/* calls func(arg) as a worker, from a thread that is not one. */
+int scheduler_run(scheduler_t *s, void (*func)(void *), void *arg);
+/*
+ *  Worker only, or fails with EPERM: spawn lets func(arg) run on any
+ *  worker, sync runs tasks until all those spawned into @c g are done.
+ */
+int scheduler_spawn(scheduler_t *s, task_group_t *g, void (*func)(void *), void *arg);
+int scheduler_sync(scheduler_t *s, task_group_t *g);
+/*
+ *  Calls body(arg, i) for i in [begin, end), splitting the range in
+ *  halves down to @c grain indices, or an eighth of each worker's share
+ *  if 0. Any thread may call it.
+ */
+int scheduler_parallel_for(scheduler_t *s, size_t begin, size_t end, size_t grain,
+                           void (*body)(void *, size_t), void *arg);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __ALGORITHMS_INTERNAL_SCHEDULER_H__ */
@@ -0,0 +1,115 @@
+/** @file       scheduler_bench.cpp
+ *  @brief      Benchmark for work-stealing scheduler.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "scheduler.h"
+
+struct fib_arg {
+    scheduler_t *s;
+    int n;
+    long result;
+};
+
+static long serial_fib(int n)
+{
+    return (n < 2) ? n : serial_fib(n - 1) + serial_fib(n - 2);
+}
+
+/* leaves below this are computed serially, as real code would. */
+static const int FIB_CUTOFF = 12;
+
+static void fib(void *arg)
+{
+    fib_arg *f = (fib_arg *)arg;
+
+    if (f->n < FIB_CUTOFF) {
+        f->result = serial_fib(f->n);
+        return;
+    }
+    task_group_t g = TASK_GROUP_INITIALIZER;
+    fib_arg a{f->s, f->n - 1, 0}, b{f->s, f->n - 2, 0};
+    scheduler_spawn(f->s, &g, fib, &a);
+    fib(&b);
+    scheduler_sync(f->s, &g);
+    f->result = a.result + b.result;
+}
+
+SCENARIO("fib をワーカー数ごとに計測する",
+         tags(".", "benchmark", "scheduler_spawn", "scheduler_sync", "parallel")) {
+
+    static const int N = 30;
+
+    GIVEN("逐次実行する") {
+        BENCHMARK("serial fib(" + std::to_string(N) + ")") {
+            return serial_fib(N);
+        };
+    }
+
+    for (size_t workers: {1, 2, 4, 8}) {
+        GIVEN(std::to_string(workers) + " ワーカーのスケジューラを作成する") {
+            scheduler_t s;
+
+            REQUIRE(scheduler_create(&s, workers, 4096) == 0);
+
+            BENCHMARK(std::to_string(workers) + " workers fib(" + std::to_string(N) + ")") {
+                fib_arg f{&s, N, 0};
+                scheduler_run(&s, fib, &f);
+                return f.result;
+            };
+
+            scheduler_destroy(&s);
+        }
+    }
+}
+
+SCENARIO("総和をワーカー数ごとに計測する",
+         tags(".", "benchmark", "scheduler_parallel_for", "parallel")) {
+
+    static const size_t COUNT = 1 << 20;
+    static const size_t CHUNKS = 256;
+
+    std::vector<double> data(COUNT, 1.0);
+    struct reduce_arg {
+        const double *data;
+        double sums[CHUNKS];
+    } r;
+    r.data = data.data();
+    auto body = [](void *arg, size_t chunk) {
+        reduce_arg *ra = (reduce_arg *)arg;
+        double sum = 0.0;
+        for (size_t i = chunk * (COUNT / CHUNKS); i < (chunk + 1) * (COUNT / CHUNKS); ++i) {
+            sum += ra->data[i];
+        }
+        ra->sums[chunk] = sum;
+    };
+
+    for (size_t workers: {1, 2, 4, 8}) {
+        GIVEN(std::to_string(workers) + " ワーカーのスケジューラを作成する") {
+            scheduler_t s;
+
+            REQUIRE(scheduler_create(&s, workers, 4096) == 0);
+
+            BENCHMARK(std::to_string(workers) + " workers sum of " + std::to_string(COUNT)) {
+                scheduler_parallel_for(&s, 0, CHUNKS, 1, body, &r);
+                double sum = 0.0;
+                for (double d: r.sums) {
+                    sum += d;
+                }
+                return sum;
+            };
+
+            scheduler_destroy(&s);
+        }
+    }
+}
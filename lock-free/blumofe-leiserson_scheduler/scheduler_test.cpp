@@ -0,0 +1,157 @@
+/** @file       scheduler_test.cpp
+ *  @brief      Unit-test for work-stealing scheduler.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "scheduler.h"
+
+struct fib_arg {
+    scheduler_t *s;
+    int n;
+    long result;
+};
+
+static void fib(void *arg)
+{
+    fib_arg *f = (fib_arg *)arg;
+
+    if (f->n < 2) {
+        f->result = f->n;
+        return;
+    }
+    task_group_t g = TASK_GROUP_INITIALIZER;
+    fib_arg a{f->s, f->n - 1, 0}, b{f->s, f->n - 2, 0};
+    scheduler_spawn(f->s, &g, fib, &a);
+    fib(&b);
+    scheduler_sync(f->s, &g);
+    f->result = a.result + b.result;
+}
+
+SCENARIO("スケジューラを作成できること",
+         tags("scheduler", "scheduler_create", "scheduler_destroy")) {
+
+    GIVEN("特になし") {
+
+        WHEN("スケジューラを作成する") {
+            scheduler_t s;
+
+            THEN("スケジューラが作成できること") {
+                REQUIRE(scheduler_create(&s, 4, 1024) == 0);
+                CHECK(scheduler_destroy(&s) == 0);
+            }
+        }
+
+        WHEN("ワーカー数 0 またはタスク数 0 で作成する") {
+            scheduler_t s;
+
+            THEN("作成に失敗すること") {
+                CHECK(scheduler_create(&s, 0, 1024) == -1);
+                CHECK(errno == EINVAL);
+                CHECK(scheduler_create(&s, 4, 0) == -1);
+                CHECK(errno == EINVAL);
+            }
+        }
+    }
+}
+
+SCENARIO("タスクを生成して完了を待てること",
+         tags("scheduler", "scheduler_run", "scheduler_spawn", "scheduler_sync")) {
+
+    GIVEN("スケジューラを作成する") {
+        scheduler_t s;
+
+        REQUIRE(scheduler_create(&s, 4, 1024) == 0);
+
+        WHEN("ワーカー外から生成/待機する") {
+            task_group_t g = TASK_GROUP_INITIALIZER;
+            fib_arg f{&s, 1, 0};
+
+            THEN("失敗すること") {
+                CHECK(scheduler_spawn(&s, &g, fib, &f) == -1);
+                CHECK(errno == EPERM);
+                CHECK(scheduler_sync(&s, &g) == -1);
+                CHECK(errno == EPERM);
+            }
+        }
+
+        WHEN("再帰的にタスクを生成する") {
+            fib_arg f{&s, 20, 0};
+
+            THEN("すべてのタスクが完了してから戻ること") {
+                REQUIRE(scheduler_run(&s, fib, &f) == 0);
+                CHECK(f.result == 6765);
+            }
+        }
+
+        CHECK(scheduler_destroy(&s) == 0);
+    }
+
+    GIVEN("タスク数の少ないスケジューラを作成する") {
+        scheduler_t s;
+
+        REQUIRE(scheduler_create(&s, 4, 4) == 0);
+
+        WHEN("上限を超えてタスクを生成する") {
+            fib_arg f{&s, 20, 0};
+
+            THEN("超えた分はその場で実行されること") {
+                REQUIRE(scheduler_run(&s, fib, &f) == 0);
+                CHECK(f.result == 6765);
+            }
+        }
+
+        CHECK(scheduler_destroy(&s) == 0);
+    }
+}
+
+SCENARIO("範囲を分割して並列に処理できること",
+         tags("scheduler", "scheduler_parallel_for", "parallel")) {
+
+    static const size_t TEST_COUNT = 100000;
+
+    GIVEN("スケジューラを作成する") {
+        scheduler_t s;
+
+        REQUIRE(scheduler_create(&s, 4, 1024) == 0);
+
+        WHEN("粒度を指定せずに処理する") {
+            std::vector<std::atomic<int>> hits(TEST_COUNT);
+            auto body = [](void *arg, size_t i) {
+                (*(std::vector<std::atomic<int>> *)arg)[i]++;
+            };
+            REQUIRE(scheduler_parallel_for(&s, 0, TEST_COUNT, 0, body, &hits) == 0);
+
+            THEN("すべての添字が 1 度ずつ処理されること") {
+                size_t wrong = 0;
+                for (auto &h: hits) {
+                    wrong += (h != 1);
+                }
+                CHECK(wrong == 0);
+            }
+        }
+
+        WHEN("空の範囲を処理する") {
+            std::atomic<int> calls{0};
+            auto body = [](void *arg, size_t) {
+                (*(std::atomic<int> *)arg)++;
+            };
+
+            THEN("1 度も呼ばれないこと") {
+                CHECK(scheduler_parallel_for(&s, 10, 10, 1, body, &calls) == 0);
+                CHECK(calls == 0);
+            }
+        }
+
+        CHECK(scheduler_destroy(&s) == 0);
+    }
+}
@@ -0,0 +1,8 @@
+#define CATCH_CONFIG_RUNNER
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+int main(int argc, char **argv)
+{
+    return Catch::Session().run(argc, argv);
+}
@@ -0,0 +1,228 @@
+/** @file       wsdeque.c
+ *  @brief      Chase-Lev work-stealing deque implementation.
+ *
+ *  The owner pushes and pops at the bottom, thieves take from the top of
+ *  a circular array indexed by the ever-growing top and bottom counters.
+ *  Only the owner writes bottom and the array, so push is two stores and
+ *  a release fence, and pop a store, a full fence and a load; the two
+ *  sides race only for the last value, where pop settles it with the
+ *  same CAS on top that every steal makes. The memory orders follow the
+ *  C11 version of Le et al.
+ *
+ *  A full array is replaced by one twice the size. A thief may still be
+ *  reading the old one, which is kept on a list until the deque is
+ *  destroyed; being half the size of its successor, all of them together
+ *  take less than the current array.
+ *
+ *  Values are copied in and out with memcpy(). A thief may copy a slot
+ *  the owner is overwriting, but then the owner has gone past it and the
+ *  thief's CAS on top fails, so the torn copy is never returned.
+ *
+ *  @sa         [D.Chase&Y.Lev,Dynamic Circular Work-Stealing Deque,SPAA 2005]
+ *  @sa         [N.M.Le&A.Pop&A.Cohen&F.Zappa Nardelli,Correct and Efficient
+ *              Work-Stealing for Weak Memory Models,PPoPP 2013]
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+
+#include "aux.h"
+#include "debug.h"
+#include "atomic.h"
+#include "wsdeque.h"
+
+struct wsdeque_array {
+    int64_t mask;                   /* slots - 1, slots a power of two. */
+    struct wsdeque_array *older;    /* the arrays this one replaced. */
+    alignas(16) uint8_t slots[];
+};
+
+static inline void *slot_of(wsdeque_t *self, struct wsdeque_array *a, int64_t i)
+{
+    return &a->slots[(size_t)(i & a->mask) * self->value_bytes];
+}
+
+static struct wsdeque_array *new_array(wsdeque_t *self, size_t slots)
+{
+    if (slots > (SIZE_MAX - sizeof(struct wsdeque_array)) / self->value_bytes) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    struct wsdeque_array *a = malloc(sizeof(*a) + (slots * self->value_bytes));
+    if (a == NULL) {
+        return NULL;
+    }
+    a->mask = (int64_t)slots - 1;
+    a->older = NULL;
+    return a;
+}
+
+/**
+ *  Replaces the owner's array, holding the values from @c t to @c b,
+ *  with one twice the size.
+ */
+static struct wsdeque_array *grow(wsdeque_t *self, struct wsdeque_array *a, int64_t t, int64_t b)
+{
+    struct wsdeque_array *bigger = new_array(self, (size_t)(a->mask + 1) * 2);
+    if (bigger == NULL) {
+        return NULL;
+    }
+    for (int64_t i = t; i < b; ++i) {
+        memcpy(slot_of(self, bigger, i), slot_of(self, a, i), self->value_bytes);
+    }
+    bigger->older = a;
+    atomic_store_explicit(&self->array, bigger, memory_order_release);
+    return bigger;
+}
+
+int wsdeque_create(wsdeque_t *q, size_t value_bytes, size_t capacity)
+{
+    if ((q == NULL) || (value_bytes == 0) || (capacity == 0)
+        || (capacity > ((size_t)INT64_MAX >> 1))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t slots = 1;
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+    q->value_bytes = value_bytes;
+    q->array = new_array(q, slots);
+    if (q->array == NULL) {
+        return -1;
+    }
+    atomic_store(&q->top, 0);
+    atomic_store(&q->bottom, 0);
+
+    return 0;
+}
+
+int wsdeque_destroy(wsdeque_t *q)
+{
+    if (q == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct wsdeque_array *a = q->array;
+    while (a != NULL) {
+        struct wsdeque_array *older = a->older;
+        free(a);
+        a = older;
+    }
+    q->array = NULL;
+
+    return 0;
+}
+
+int wsdeque_push(wsdeque_t *q, const void *value)
+{
+    if ((q == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int64_t b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&q->top, memory_order_acquire);
+    struct wsdeque_array *a = atomic_load_explicit(&q->array, memory_order_relaxed);
+    if (b - t > a->mask) {
+        a = grow(q, a, t, b);
+        if (a == NULL) {
+            return -1;
+        }
+    }
+    memcpy(slot_of(q, a, b), value, q->value_bytes);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+
+    return 0;
+}
+
+int wsdeque_pop(wsdeque_t *q, void *value)
+{
+    if ((q == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int64_t b = atomic_load_explicit(&q->bottom, memory_order_relaxed) - 1;
+    struct wsdeque_array *a = atomic_load_explicit(&q->array, memory_order_relaxed);
+    atomic_store_explicit(&q->bottom, b, memory_order_relaxed);
+    /* thieves must see the claim on b before top is read back. */
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&q->top, memory_order_relaxed);
+
+    if (t > b) {
+        atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+        errno = ENOENT;
+        return -1;
+    }
+    memcpy(value, slot_of(q, a, b), q->value_bytes);
+    if (t < b) {
+        return 0;
+    }
+
+    /* the last value: race the thieves for it. */
+    bool won = atomic_compare_exchange_strong_explicit(&q->top, &t, t + 1,
+                                                       memory_order_seq_cst,
+                                                       memory_order_relaxed);
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+    if (!won) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    return 0;
+}
+
+int wsdeque_steal(wsdeque_t *q, void *value)
+{
+    if ((q == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int64_t t = atomic_load_explicit(&q->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&q->bottom, memory_order_acquire);
+    if (t >= b) {
+        errno = ENOENT;
+        return -1;
+    }
+
+    /* acquire rather than consume, which compilers promote anyway. */
+    struct wsdeque_array *a = atomic_load_explicit(&q->array, memory_order_acquire);
+    memcpy(value, slot_of(q, a, t), q->value_bytes);
+    if (!atomic_compare_exchange_strong_explicit(&q->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    return 0;
+}
+
+size_t wsdeque_size(wsdeque_t *q)
+{
+    if (q == NULL) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    int64_t b = atomic_load(&q->bottom);
+    int64_t t = atomic_load(&q->top);
+    return (b > t) ? (size_t)(b - t) : 0;
+}
@@ -0,0 +1,62 @@
+/** @file       wsdeque.h
+ *  @brief      Chase-Lev work-stealing deque implementation.
+ *
+ *  @sa         [D.Chase&Y.Lev,Dynamic Circular Work-Stealing Deque,SPAA 2005]
+ *  @sa         [N.M.Le&A.Pop&A.Cohen&F.Zappa Nardelli,Correct and Efficient
+ *              Work-Stealing for Weak Memory Models,PPoPP 2013]
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __ALGORITHMS_INTERNAL_WSDEQUE_H__
+#define __ALGORITHMS_INTERNAL_WSDEQUE_H__
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "atomic.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct wsdeque_array;
+
+typedef struct wsdeque {
+    /* owner side. */
+    alignas(CACHE_LINE_BYTES) int64_t bottom;
+    /* thieves' side. */
+    alignas(CACHE_LINE_BYTES) int64_t top;
+    /* read-mostly; replaced by the owner when it grows. */
+    alignas(CACHE_LINE_BYTES) struct wsdeque_array *array;
+    size_t value_bytes;
+} wsdeque_t;
+
+/* capacity is the initial one, rounded up to a power of two. */
+int wsdeque_create(wsdeque_t *q, size_t value_bytes, size_t capacity);
+int wsdeque_destroy(wsdeque_t *q);
+/*
+ *  Owner only: push and pop at the bottom. Push grows the array when
+ *  full and fails with ENOMEM only if that fails; pop fails with ENOENT
+ *  when empty.
+ */
+int wsdeque_push(wsdeque_t *q, const void *value);
+int wsdeque_pop(wsdeque_t *q, void *value);
+/*
+ *  Any thread: takes from the top. Fails with ENOENT when empty and with
+ *  EAGAIN when another thief or the owner took the value first; *value
+ *  is then unspecified.
+ */
+int wsdeque_steal(wsdeque_t *q, void *value);
+/* a snapshot; exact only while nobody else uses the deque. */
+size_t wsdeque_size(wsdeque_t *q);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __ALGORITHMS_INTERNAL_WSDEQUE_H__ */
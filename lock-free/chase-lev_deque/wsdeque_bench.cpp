@@ -0,0 +1,85 @@
+/** @file       wsdeque_bench.cpp
+ *  @brief      Benchmark for Chase-Lev work-stealing deque.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <thread>
+
+#include "utils.hpp"
+
+#include "wsdeque.h"
+#include "deque.h"
+
+SCENARIO("所有者側の操作コストを計測する",
+         tags(".", "benchmark", "wsdeque_push", "wsdeque_pop")) {
+
+    GIVEN("両端キューを作成する") {
+        wsdeque_t w;
+        deq_t d;
+
+        REQUIRE(wsdeque_create(&w, sizeof(int), 1024) == 0);
+        REQUIRE(deque_create(&d, sizeof(int), 1024) == 0);
+
+        BENCHMARK("chase-lev push / pop") {
+            int data = 10, buf;
+            wsdeque_push(&w, &data);
+            return wsdeque_pop(&w, &buf);
+        };
+
+        BENCHMARK("sundell-tsigas push / pop") {
+            int data = 10, buf;
+            deque_push(&d, &data);
+            return deque_pop(&d, &buf);
+        };
+
+        BENCHMARK("chase-lev push / steal") {
+            int data = 10, buf;
+            wsdeque_push(&w, &data);
+            return wsdeque_steal(&w, &buf);
+        };
+
+        deque_destroy(&d);
+        wsdeque_destroy(&w);
+    }
+}
+
+SCENARIO("他のスレッドが奪う間の所有者側の操作コストを計測する",
+         tags(".", "benchmark", "wsdeque_push", "wsdeque_pop", "wsdeque_steal", "parallel")) {
+
+    static const int OPS = 10000;
+
+    GIVEN("両端キューを作成する") {
+        wsdeque_t w;
+
+        REQUIRE(wsdeque_create(&w, sizeof(int), 1024) == 0);
+
+        std::atomic<bool> done{false};
+        std::thread thief([&] {
+            int buf;
+            while (!done.load()) {
+                wsdeque_steal(&w, &buf);
+            }
+        });
+
+        BENCHMARK(std::to_string(OPS) + " x push / pop with a thief") {
+            int buf = 0;
+            for (int i = 0; i < OPS; ++i) {
+                wsdeque_push(&w, &i);
+                wsdeque_push(&w, &i);
+                wsdeque_pop(&w, &buf);
+            }
+            return buf;
+        };
+
+        done = true;
+        thief.join();
+        wsdeque_destroy(&w);
+    }
+}
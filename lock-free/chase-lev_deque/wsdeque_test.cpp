@@ -0,0 +1,181 @@
+/** @file       wsdeque_test.cpp
+ *  @brief      Unit-test for Chase-Lev work-stealing deque.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "wsdeque.h"
+
+SCENARIO("ワークスティーリング両端キューを作成できること",
+         tags("wsdeque", "wsdeque_create", "wsdeque_destroy")) {
+
+    GIVEN("特になし") {
+
+        WHEN("両端キューを作成する") {
+            wsdeque_t q;
+
+            THEN("両端キューが作成できること") {
+                REQUIRE(wsdeque_create(&q, sizeof(int), 16) == 0);
+                CHECK(wsdeque_size(&q) == 0);
+                wsdeque_destroy(&q);
+            }
+        }
+
+        WHEN("値のサイズ 0 または容量 0 で作成する") {
+            wsdeque_t q;
+
+            THEN("作成に失敗すること") {
+                CHECK(wsdeque_create(&q, 0, 16) == -1);
+                CHECK(errno == EINVAL);
+                CHECK(wsdeque_create(&q, sizeof(int), 0) == -1);
+                CHECK(errno == EINVAL);
+            }
+        }
+    }
+}
+
+SCENARIO("所有者は末尾から、他のスレッドは先頭から取得できること",
+         tags("wsdeque", "wsdeque_push", "wsdeque_pop", "wsdeque_steal")) {
+
+    GIVEN("両端キューを作成する") {
+        wsdeque_t q;
+
+        REQUIRE(wsdeque_create(&q, sizeof(int), 16) == 0);
+
+        WHEN("複数のデータを追加する") {
+            int data[]{10, 20, 30, 40};
+
+            INFO("データ: " + array_to_string(data));
+
+            for (auto &d: data) {
+                REQUIRE(wsdeque_push(&q, &d) == 0);
+            }
+            CHECK(wsdeque_size(&q) == 4);
+
+            THEN("pop は後入れ先出し、steal は先入れ先出しで取得できること") {
+                int buf;
+                CHECK(wsdeque_pop(&q, &buf) == 0);
+                CHECK(buf == 40);
+                CHECK(wsdeque_steal(&q, &buf) == 0);
+                CHECK(buf == 10);
+                CHECK(wsdeque_steal(&q, &buf) == 0);
+                CHECK(buf == 20);
+                CHECK(wsdeque_pop(&q, &buf) == 0);
+                CHECK(buf == 30);
+                CHECK(wsdeque_size(&q) == 0);
+            }
+        }
+
+        WHEN("空の状態で取得する") {
+            int buf;
+
+            THEN("取得に失敗すること") {
+                CHECK(wsdeque_pop(&q, &buf) == -1);
+                CHECK(errno == ENOENT);
+                CHECK(wsdeque_steal(&q, &buf) == -1);
+                CHECK(errno == ENOENT);
+            }
+        }
+
+        wsdeque_destroy(&q);
+    }
+
+    GIVEN("容量 4 の両端キューを作成する") {
+        wsdeque_t q;
+
+        REQUIRE(wsdeque_create(&q, sizeof(int), 4) == 0);
+
+        WHEN("先頭から取得しながら容量を超えて追加する") {
+            static const int TEST_COUNT = 1000;
+            int buf;
+            for (int i = 0; i < TEST_COUNT; ++i) {
+                REQUIRE(wsdeque_push(&q, &i) == 0);
+                if ((i % 3) == 0) {
+                    REQUIRE(wsdeque_steal(&q, &buf) == 0);
+                }
+            }
+
+            THEN("拡張後も順序を保って取得できること") {
+                int steals = (TEST_COUNT + 2) / 3;
+                CHECK(wsdeque_size(&q) == (size_t)(TEST_COUNT - steals));
+                CHECK(wsdeque_steal(&q, &buf) == 0);
+                CHECK(buf == steals);
+                for (int i = TEST_COUNT - 1; i > steals; --i) {
+                    REQUIRE(wsdeque_pop(&q, &buf) == 0);
+                    REQUIRE(buf == i);
+                }
+                CHECK(wsdeque_pop(&q, &buf) == -1);
+            }
+        }
+
+        wsdeque_destroy(&q);
+    }
+}
+
+SCENARIO("所有者と複数のスレッドが同時に取得できること",
+         tags("wsdeque", "wsdeque_push", "wsdeque_pop", "wsdeque_steal", "parallel")) {
+
+    static const int TEST_COUNT = 100000;
+    static const int THIEVES = 3;
+
+    GIVEN("容量の小さい両端キューを作成する") {
+        wsdeque_t q;
+
+        REQUIRE(wsdeque_create(&q, sizeof(int), 8) == 0);
+
+        WHEN("所有者が追加/取得する間に、３つのスレッドから奪う") {
+            std::atomic<bool> done{false};
+            std::vector<std::vector<int>> taken(THIEVES + 1);
+            std::vector<std::thread> thieves;
+            for (int t = 0; t < THIEVES; ++t) {
+                thieves.emplace_back([&, t] {
+                    int buf;
+                    while (!done.load() || (wsdeque_size(&q) > 0)) {
+                        if (wsdeque_steal(&q, &buf) == 0) {
+                            taken[t].push_back(buf);
+                        }
+                    }
+                });
+            }
+            int buf;
+            for (int i = 0; i < TEST_COUNT; ++i) {
+                REQUIRE(wsdeque_push(&q, &i) == 0);
+                if (((i % 4) == 0) && (wsdeque_pop(&q, &buf) == 0)) {
+                    taken[THIEVES].push_back(buf);
+                }
+            }
+            done = true;
+            for (auto &t: thieves) {
+                t.join();
+            }
+
+            THEN("すべてのデータが 1 度ずつ取得できること") {
+                BITFLAG flags = bitflag_create(TEST_COUNT);
+                size_t total = 0;
+                bool twice = false;
+                for (auto &v: taken) {
+                    total += v.size();
+                    for (int d: v) {
+                        twice = twice || bitflag_check(flags, d);
+                        bitflag_set(flags, d);
+                    }
+                }
+                CHECK(total == TEST_COUNT);
+                CHECK_FALSE(twice);
+                bitflag_destroy(flags);
+            }
+        }
+
+        wsdeque_destroy(&q);
+    }
+}
@@ -0,0 +1,382 @@
+/** @file       ts_stack.c
+ *  @brief      Time-Stamped Stack implementation.
+ *
+ *  Every thread pushes into its own pool, a Treiber list of nodes
+ *  stamped with the time of the push, so pushes on different pools never
+ *  touch a shared word. A pop scans the top of every pool and takes the
+ *  youngest untaken node by flipping its @c taken bit; nodes pushed after
+ *  the pop started are taken at once (elimination). Taken nodes are
+ *  unlinked from the top of their pool and recycled through a per-pool
+ *  free list.
+ *
+ *  The stack is LIFO for each thread's own pushes and, across threads,
+ *  as far as the timestamps order them.
+ *
+ *  @sa         [M.Dodds&A.Haas&CM.Kirsch,A Scalable, Correct Time-Stamped
+ *              Stack,POPL 2015]
+ *              (https://dl.acm.org/doi/10.1145/2676726.2676963)
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include "aux.h"
+#include "debug.h"
+#include "atomic.h"
+#include "ts_stack.h"
+
+#define TS_STACK_POOLS_MAX 64
+
+typedef uint32_t ts_ref_t;      /* 1-based node index, 0 is none. */
+
+#define TS_REF_NONE 0
+#define TS_CAPACITY_MAX UINT32_MAX
+
+/* node state: version << 1 | taken. */
+#define TS_TAKEN 1
+
+struct ts_head {
+    alignas(8) ts_ref_t node;
+    uint32_t aba;
+};
+
+struct ts_node {
+    _Atomic uint64_t state;
+    _Atomic uint64_t timestamp;
+    _Atomic ts_ref_t next;
+    alignas(sizeof(void *)) uint8_t value[];
+};
+
+/**
+ *  Per-thread pool: the pushed nodes, youngest on top, and the free
+ *  nodes this pool hands out. Threads are spread over the pools by a
+ *  thread number, so more threads than pools share them safely.
+ */
+struct ts_pool {
+    alignas(CACHE_LINE_BYTES) struct ts_head top;
+    struct ts_head free;
+    _Atomic intptr_t size;  /* pushes minus pops counted here, may be negative. */
+};
+
+struct ts_stack {
+    size_t value_bytes;
+    size_t node_bytes;
+    size_t capacity;
+    size_t npools;
+    struct ts_pool *pools;
+#if !defined(__x86_64__)
+    alignas(CACHE_LINE_BYTES) _Atomic uint64_t clock;
+#endif
+    alignas(16) void *node_buffer;
+};
+
+static inline size_t node_byte_aligned(size_t value_bytes)
+{
+    static const size_t byte_aligned = 16;
+
+    size_t node_bytes = sizeof(struct ts_node) + value_bytes;
+    if (node_bytes % byte_aligned) {
+        node_bytes += byte_aligned - (node_bytes % byte_aligned);
+    }
+    return node_bytes;
+}
+
+static inline struct ts_node *node_of(struct ts_stack *self, ts_ref_t ref)
+{
+    return (struct ts_node *)((uintptr_t)&self->node_buffer
+                              + (self->node_bytes * (ref - 1)));
+}
+
+/**
+ *  Timestamp of a push, and the start time of a pop.
+ *
+ *  Uses the invariant TSC on x86-64 (rdtscp waits for earlier
+ *  instructions), a shared counter elsewhere.
+ */
+static inline uint64_t ts_now(struct ts_stack *self)
+{
+#if defined(__x86_64__)
+    UNUSED_VARIABLE(self);
+    unsigned int aux;
+    return __builtin_ia32_rdtscp(&aux);
+#else
+    return atomic_fetch_add(&self->clock, 1) + 1;
+#endif
+}
+
+static inline size_t pool_of(struct ts_stack *self)
+{
+    static _Atomic uint32_t threads;
+    static _Thread_local uint32_t id;   /* 1-based, 0 is unassigned. */
+
+    if (id == 0) {
+        id = atomic_fetch_add(&threads, 1) + 1;
+    }
+    return (id - 1) % self->npools;
+}
+
+static void list_push(struct ts_stack *self, struct ts_head *head, ts_ref_t ref)
+{
+    struct ts_node *node = node_of(self, ref);
+    struct ts_head next, orig = atomic_load(head);
+    do {
+        atomic_store_explicit(&node->next, orig.node, memory_order_relaxed);
+        next.aba = orig.aba + 1;
+        next.node = ref;
+    } while (!atomic_compare_exchange_weak(head, &orig, next));
+}
+
+static ts_ref_t list_pop(struct ts_stack *self, struct ts_head *head)
+{
+    struct ts_head next, orig = atomic_load(head);
+    do {
+        if (orig.node == TS_REF_NONE) {
+            return TS_REF_NONE;
+        }
+        next.aba = orig.aba + 1;
+        next.node = atomic_load_explicit(&node_of(self, orig.node)->next,
+                                         memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak(head, &orig, next));
+    return orig.node;
+}
+
+/**
+ *  Moves the taken nodes at the top of @c pool to its free list.
+ */
+static void pool_unlink_taken(struct ts_stack *self, struct ts_pool *pool)
+{
+    struct ts_head next, orig = atomic_load(&pool->top);
+    while (orig.node != TS_REF_NONE) {
+        struct ts_node *node = node_of(self, orig.node);
+        if (!(atomic_load(&node->state) & TS_TAKEN)) {
+            break;
+        }
+        next.aba = orig.aba + 1;
+        next.node = atomic_load_explicit(&node->next, memory_order_relaxed);
+        if (atomic_compare_exchange_weak(&pool->top, &orig, next)) {
+            list_push(self, &pool->free, orig.node);
+            orig = next;
+        }
+    }
+}
+
+/**
+ *  Finds the youngest untaken node of @c pool.
+ *
+ *  A stale walk may wander onto recycled nodes; it is bounded by the
+ *  capacity and any pick is confirmed by the versioned state.
+ *
+ *  @return Returns the node, TS_REF_NONE if there is none.
+ */
+static ts_ref_t pool_youngest(struct ts_stack *self, struct ts_pool *pool,
+                              struct ts_head *top, uint64_t *state)
+{
+    *top = atomic_load(&pool->top);
+    ts_ref_t ref = top->node;
+    for (size_t n = 0; (ref != TS_REF_NONE) && (n < self->capacity); ++n) {
+        struct ts_node *node = node_of(self, ref);
+        uint64_t st = atomic_load(&node->state);
+        if (!(st & TS_TAKEN)) {
+            *state = st;
+            return ref;
+        }
+        ref = atomic_load_explicit(&node->next, memory_order_relaxed);
+    }
+    return TS_REF_NONE;
+}
+
+/**
+ *  Takes @c ref if it is still in @c state. The value is copied first:
+ *  once taken, the node may be unlinked and recycled by anyone.
+ */
+static bool take(struct ts_stack *self, struct ts_pool *pool, ts_ref_t ref,
+                 uint64_t state, void *value)
+{
+    struct ts_node *node = node_of(self, ref);
+    memcpy(value, node->value, self->value_bytes);
+    if (!atomic_compare_exchange_strong(&node->state, &state, state | TS_TAKEN)) {
+        return false;
+    }
+    pool_unlink_taken(self, pool);
+    return true;
+}
+
+ts_stack_t ts_stack_create(size_t value_bytes, size_t capacity)
+{
+    if ((capacity == 0) || (capacity > TS_CAPACITY_MAX)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    size_t node_bytes = node_byte_aligned(value_bytes);
+    size_t bytes = sizeof(struct ts_stack) + (node_bytes * capacity);
+    if (bytes % alignof(struct ts_stack)) {
+        bytes += alignof(struct ts_stack) - (bytes % alignof(struct ts_stack));
+    }
+    struct ts_stack *self = aligned_alloc(alignof(struct ts_stack), bytes);
+    if (self == NULL) {
+        return NULL;
+    }
+    memset(self, 0, bytes);
+    self->value_bytes = value_bytes;
+    self->node_bytes = node_bytes;
+    self->capacity = capacity;
+
+    long nprocs = sysconf(_SC_NPROCESSORS_CONF);
+    self->npools = (nprocs < 1) ? 1
+                 : (nprocs > TS_STACK_POOLS_MAX) ? TS_STACK_POOLS_MAX : (size_t)nprocs;
+    self->pools = aligned_alloc(alignof(struct ts_pool),
+                                sizeof(*self->pools) * self->npools);
+    if (self->pools == NULL) {
+        free(self);
+        return NULL;
+    }
+    memset(self->pools, 0, sizeof(*self->pools) * self->npools);
+
+    /* deal the nodes out to the pools' free lists, all taken. */
+    for (size_t i = 0; i < capacity; ++i) {
+        ts_ref_t ref = (ts_ref_t)(i + 1);
+        atomic_store(&node_of(self, ref)->state, TS_TAKEN);
+        list_push(self, &self->pools[i % self->npools].free, ref);
+    }
+
+    return (ts_stack_t)self;
+}
+
+int ts_stack_destroy(ts_stack_t s)
+{
+    if (s == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct ts_stack *self = (struct ts_stack *)s;
+    free(self->pools);
+    free(self);
+    return 0;
+}
+
+size_t ts_stack_size(ts_stack_t s)
+{
+    if (s == NULL) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    struct ts_stack *self = (struct ts_stack *)s;
+    intptr_t size = 0;
+    for (size_t i = 0; i < self->npools; ++i) {
+        size += atomic_load_explicit(&self->pools[i].size, memory_order_relaxed);
+    }
+    return (size > 0) ? (size_t)size : 0;
+}
+
+int ts_stack_push(ts_stack_t s, void *value)
+{
+    if ((s == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct ts_stack *self = (struct ts_stack *)s;
+    size_t home = pool_of(self);
+    struct ts_pool *pool = &self->pools[home];
+    ts_ref_t ref = TS_REF_NONE;
+    for (size_t k = 0; (k < self->npools) && (ref == TS_REF_NONE); ++k) {
+        struct ts_pool *donor = &self->pools[(home + k) % self->npools];
+        pool_unlink_taken(self, donor);
+        ref = list_pop(self, &donor->free);
+    }
+    if (ref == TS_REF_NONE) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    struct ts_node *node = node_of(self, ref);
+    memcpy(node->value, value, self->value_bytes);
+    atomic_store(&node->timestamp, ts_now(self));
+    /* free nodes are taken, so this bumps the version and clears the bit. */
+    atomic_fetch_add(&node->state, 1);
+    list_push(self, &pool->top, ref);
+    atomic_inc(&pool->size);
+
+    return 0;
+}
+
+int ts_stack_pop(ts_stack_t s, void *value)
+{
+    if ((s == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct ts_stack *self = (struct ts_stack *)s;
+    size_t home = pool_of(self);
+    uint64_t start = ts_now(self);
+    struct ts_head tops[TS_STACK_POOLS_MAX];
+    while (true) {
+        ts_ref_t best = TS_REF_NONE;
+        uint64_t best_state = 0, best_ts = 0;
+        size_t best_pool = 0;
+        bool eliminated = false;
+
+        for (size_t k = 0; k < self->npools; ++k) {
+            size_t i = (home + k) % self->npools;
+            uint64_t state;
+            ts_ref_t ref = pool_youngest(self, &self->pools[i], &tops[i], &state);
+            if (ref == TS_REF_NONE) {
+                continue;
+            }
+            uint64_t ts = atomic_load(&node_of(self, ref)->timestamp);
+            if (ts > start) {
+                /* pushed while we were popping: take it right away. */
+                if (take(self, &self->pools[i], ref, state, value)) {
+                    eliminated = true;
+                    break;
+                }
+                continue;
+            }
+            if ((best == TS_REF_NONE) || (ts > best_ts)) {
+                best = ref;
+                best_state = state;
+                best_ts = ts;
+                best_pool = i;
+            }
+        }
+
+        if (eliminated
+            || ((best != TS_REF_NONE)
+                && take(self, &self->pools[best_pool], best, best_state, value))) {
+            atomic_dec(&self->pools[home].size);
+            return 0;
+        }
+        if (best != TS_REF_NONE) {
+            continue;   /* lost the race for it, rescan. */
+        }
+
+        /* nothing seen: empty unless some pool changed during the scan. */
+        bool unchanged = true;
+        for (size_t i = 0; (i < self->npools) && unchanged; ++i) {
+            struct ts_head top = atomic_load(&self->pools[i].top);
+            unchanged = (top.node == tops[i].node) && (top.aba == tops[i].aba);
+        }
+        if (unchanged) {
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+}
@@ -0,0 +1,33 @@
+/** @file       ts_stack.h
+ *  @brief      Time-Stamped Stack implementation.
+ *
+ *  @sa         [M.Dodds&A.Haas&CM.Kirsch,A Scalable, Correct Time-Stamped
+ *              Stack,POPL 2015]
+ *              (https://dl.acm.org/doi/10.1145/2676726.2676963)
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __ALGORITHMS_INTERNAL_TS_STACK_H__
+#define __ALGORITHMS_INTERNAL_TS_STACK_H__
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct {} *ts_stack_t;
+
+ts_stack_t ts_stack_create(size_t value_bytes, size_t capacity);
+int ts_stack_destroy(ts_stack_t s);
+size_t ts_stack_size(ts_stack_t s);
+int ts_stack_push(ts_stack_t s, void *value);
+int ts_stack_pop(ts_stack_t s, void *value);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __ALGORITHMS_INTERNAL_TS_STACK_H__ */
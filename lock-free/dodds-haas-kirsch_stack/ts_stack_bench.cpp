@@ -0,0 +1,94 @@
+/** @file       ts_stack_bench.cpp
+ *  @brief      Benchmark for Time-Stamped Stack.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <thread>
+#include <vector>
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+#include "utils.hpp"
+
+#include "ts_stack.h"
+#include "stack.h"
+
+SCENARIO("スタックの操作コストを計測する", tags(".", "benchmark", "ts_stack_push", "ts_stack_pop")) {
+
+    GIVEN("スタックを作成する") {
+        ts_stack_t ts;
+        stack_t s;
+
+        REQUIRE((ts = ts_stack_create(sizeof(int), 1024)) != NULL);
+        REQUIRE((s = stack_create(sizeof(int), 1024)) != NULL);
+
+        BENCHMARK("ts-stack push / pop") {
+            int data = 10, buf;
+            ts_stack_push(ts, &data);
+            return ts_stack_pop(ts, &buf);
+        };
+        BENCHMARK("wellons push / pop") {
+            int data = 10, buf;
+            stack_push(s, &data);
+            return stack_pop(s, &buf);
+        };
+
+        stack_destroy(s);
+        ts_stack_destroy(ts);
+    }
+}
+
+/**
+ *  Runs @c threads threads, each doing @c ops balanced push/pop pairs.
+ */
+template<typename Push, typename Pop>
+static void run_balanced(int threads, int ops, Push push, Pop pop)
+{
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([=] {
+            int data = t, buf;
+            for (int i = 0; i < ops; ++i) {
+                push(&data);
+                pop(&buf);
+            }
+        });
+    }
+    for (auto &w: workers) {
+        w.join();
+    }
+}
+
+SCENARIO("TS-stack と Wellons stack をスレッド数ごとに比較する",
+         tags(".", "benchmark", "ts_stack_create", "parallel")) {
+
+    static const int OPS = 10000;
+
+    GIVEN("スタックを作成する") {
+        ts_stack_t ts;
+        stack_t s;
+
+        REQUIRE((ts = ts_stack_create(sizeof(int), 1024)) != NULL);
+        REQUIRE((s = stack_create(sizeof(int), 1024)) != NULL);
+
+        for (int threads: {1, 2, 4, 8, 16}) {
+            BENCHMARK("ts-stack " + std::to_string(threads) + " threads") {
+                run_balanced(threads, OPS,
+                             [=](int *v) { return ts_stack_push(ts, v); },
+                             [=](int *v) { return ts_stack_pop(ts, v); });
+            };
+            BENCHMARK("wellons " + std::to_string(threads) + " threads") {
+                run_balanced(threads, OPS,
+                             [=](int *v) { return stack_push(s, v); },
+                             [=](int *v) { return stack_pop(s, v); });
+            };
+        }
+
+        stack_destroy(s);
+        ts_stack_destroy(ts);
+    }
+}
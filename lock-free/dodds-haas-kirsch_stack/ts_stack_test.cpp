@@ -0,0 +1,175 @@
+/** @file       ts_stack_test.cpp
+ *  @brief      Unit-test for Time-Stamped Stack.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <sched.h>
+#include <pthread.h>
+#include <catch2/catch.hpp>
+
+#include "utils.hpp"
+
+#include "ts_stack.h"
+
+extern "C" {
+#include "debug.h"
+}
+
+SCENARIO("スタックを作成できること", tags("ts_stack", "ts_stack_create", "ts_stack_destroy")) {
+
+    GIVEN("特になし") {
+
+        WHEN("スタックを作成する") {
+            size_t capacity{1};
+
+            INFO("容量: " + std::to_string(capacity));
+
+            THEN("スタックが作成できること") {
+                ts_stack_t s;
+                REQUIRE((s = ts_stack_create(sizeof(int), capacity)) != NULL);
+                ts_stack_destroy(s);
+            }
+        }
+
+        WHEN("容量 0 のスタックを作成する") {
+
+            THEN("スタックが作成できないこと") {
+                CHECK(ts_stack_create(sizeof(int), 0) == NULL);
+                CHECK(errno == EINVAL);
+            }
+        }
+
+        WHEN("NULL を破棄する") {
+
+            THEN("破棄に失敗すること") {
+                CHECK(ts_stack_destroy(NULL) == -1);
+                CHECK(errno == EINVAL);
+            }
+        }
+    }
+}
+
+SCENARIO("スタックへのデータの追加/取得が繰り返しできること",
+         tags("ts_stack", "ts_stack_push", "ts_stack_pop", "reusable")) {
+
+    GIVEN("サイズの十分なスタックを作成する") {
+        ts_stack_t s;
+        size_t capacity{2};
+
+        INFO("容量: " + std::to_string(capacity));
+
+        REQUIRE((s = ts_stack_create(sizeof(int), capacity)) != NULL);
+
+        WHEN("スタックへのデータ追加/取得を繰り返す") {
+
+            THEN("同じスレッドからは後入れ先出しで取得できること") {
+                int data, buf;
+                CHECK((data = 10, ts_stack_push(s, &data)) == 0);
+                CHECK((data = 20, ts_stack_push(s, &data)) == 0);
+                CHECK((ts_stack_pop(s, &buf)?:buf) == 20);
+                CHECK((data = 30, ts_stack_push(s, &data)) == 0);
+                CHECK((ts_stack_pop(s, &buf)?:buf) == 30);
+                CHECK((data = 40, ts_stack_push(s, &data)) == 0);
+                CHECK((ts_stack_pop(s, &buf)?:buf) == 40);
+                CHECK((ts_stack_pop(s, &buf)?:buf) == 10);
+                CHECK((data = 50, ts_stack_push(s, &data)) == 0);
+                CHECK((ts_stack_pop(s, &buf)?:buf) == 50);
+            }
+
+            THEN("容量を超えて追加できず、空からは取得できないこと") {
+                int data = 10, buf;
+                CHECK(ts_stack_push(s, &data) == 0);
+                CHECK(ts_stack_push(s, &data) == 0);
+                CHECK(ts_stack_push(s, &data) == -1);
+                CHECK(errno == ENOMEM);
+                CHECK(ts_stack_size(s) == capacity);
+                CHECK(ts_stack_pop(s, &buf) == 0);
+                CHECK(ts_stack_pop(s, &buf) == 0);
+                CHECK(ts_stack_pop(s, &buf) == -1);
+                CHECK(errno == ENOMEM);
+                CHECK(ts_stack_size(s) == 0);
+            }
+        }
+
+        ts_stack_destroy(s);
+    }
+}
+
+SCENARIO("スタックへの並列アクセスが可能であること",
+         tags("ts_stack", "ts_stack_push", "ts_stack_pop", "parallel")) {
+
+    GIVEN("サイズの十分なスタックを作成する") {
+        ts_stack_t s;
+        size_t capacity{20000};
+
+        INFO("容量: " + std::to_string(capacity));
+
+        REQUIRE((s = ts_stack_create(sizeof(int), capacity)) != NULL);
+
+        struct param {
+            int count;
+            int offset;
+            std::function<int(int)> callback;
+        };
+        auto worker = [&](void *arg) -> void * {
+            struct param *prm = (struct param *)arg;
+            for (int i = 0; i < prm->count; ++i) {
+                if (prm->callback(prm->offset + i) != 0) {
+                    return (void *)(intptr_t)i;
+                }
+            }
+            return (void *)(intptr_t)prm->count;
+        };
+
+        WHEN("４つのスレッドから同時に追加/取得する (push / pop)") {
+            static const int TEST_COUNT = 10000;
+
+            auto pusher = [&](int data) -> int {
+                return ts_stack_push(s, &data);
+            };
+            BITFLAG bf = bitflag_create(TEST_COUNT * 2);
+            auto poper = [&](int) -> int {
+                int buf = -1;
+                while (ts_stack_pop(s, &buf) != 0) {
+                    sched_yield();
+                }
+                return bitflag_set(bf, buf);
+            };
+
+            pthread_t thr[4];
+            struct param prm[4] = {
+                {.count = TEST_COUNT, .offset = 0, .callback = pusher},
+                {.count = TEST_COUNT, .offset = TEST_COUNT, .callback = pusher},
+                {.count = TEST_COUNT, .offset = 0, .callback = poper},
+                {.count = TEST_COUNT, .offset = 0, .callback = poper},
+            };
+            for (int i = 0; i < 4; ++i) {
+                REQUIRE(pthread_create(&thr[i], NULL, Lambda::ptr<void *, void *>(worker), &prm[i]) == 0);
+            }
+
+            THEN("データが追加/取得できること") {
+                intptr_t count = 0;
+                for (int i = 0; i < 4; ++i) {
+                    REQUIRE((pthread_join(thr[i], (void **)&count)?:count) == TEST_COUNT);
+                }
+
+                bool is_all_set = true;
+                for (int i = 0; i < (TEST_COUNT * 2); ++i) {
+                    if (!bitflag_check(bf, i)) {
+                        is_all_set = false;
+                    }
+                }
+                CHECK(is_all_set == true);
+                CHECK(ts_stack_size(s) == 0);
+            }
+
+            bitflag_destroy(bf);
+        }
+
+        ts_stack_destroy(s);
+    }
+}
@@ -0,0 +1,66 @@
+/** @file       spsc.h
+ *  @brief      Single-producer/single-consumer ring implementation.
+ *
+ *  @sa         [L.Lamport,Specifying Concurrent Program Modules,TOPLAS 1983]
+ *  @sa         [J.Giacomoni&T.Moseley&M.Vachharajani,FastForward for
+ *              Efficient Pipeline Parallelism,PPoPP 2008]
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __ALGORITHMS_INTERNAL_SPSC_H__
+#define __ALGORITHMS_INTERNAL_SPSC_H__
+
+#include <stdalign.h>
+#include <stddef.h>
+
+#include "atomic.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct spsc {
+    /* written by the producer, read by the consumer. */
+    alignas(CACHE_LINE_BYTES) size_t tail;
+    /* producer only. */
+    alignas(CACHE_LINE_BYTES) size_t head_cache;
+    size_t tail_local;
+    size_t tail_pending;
+    /* written by the consumer, read by the producer. */
+    alignas(CACHE_LINE_BYTES) size_t head;
+    /* consumer only. */
+    alignas(CACHE_LINE_BYTES) size_t tail_cache;
+    size_t head_local;
+    size_t head_pending;
+    /* read-only. */
+    alignas(CACHE_LINE_BYTES) void *buffer;
+    size_t mask;                /* capacity - 1, the capacity is a power of two. */
+    size_t value_bytes;
+    size_t batch;
+} spsc_t;
+
+/*
+ *  The capacity is rounded up to a power of two. Each side publishes its
+ *  index once every batch operations (1: every operation), and whenever
+ *  it finds the ring full or empty; the producer publishes the rest with
+ *  spsc_flush().
+ */
+int spsc_create(spsc_t *q, size_t value_bytes, size_t capacity, size_t batch);
+int spsc_destroy(spsc_t *q);
+size_t spsc_capacity(spsc_t *q);
+/* producer only. fails with ENOMEM while full. */
+int spsc_enqueue(spsc_t *q, const void *value);
+/* producer only. makes every enqueued value visible to the consumer. */
+int spsc_flush(spsc_t *q);
+/* consumer only. fails with ENOENT while empty. */
+int spsc_dequeue(spsc_t *q, void *value);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __ALGORITHMS_INTERNAL_SPSC_H__ */
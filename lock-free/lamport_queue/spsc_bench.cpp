@@ -0,0 +1,110 @@
+/** @file       spsc_bench.cpp
+ *  @brief      Benchmark for Single-producer/single-consumer ring.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <functional>
+#include <sched.h>
+#include <thread>
+
+#include "utils.hpp"
+
+#include "spsc.h"
+#include "queue.h"
+
+SCENARIO("キューの操作コストを計測する", tags(".", "benchmark", "spsc_enqueue", "spsc_dequeue")) {
+
+    GIVEN("キューを作成する") {
+        spsc_t s;
+        queue_t q;
+
+        REQUIRE(spsc_create(&s, sizeof(int), 1024, 1) == 0);
+        REQUIRE(queue_create(&q, sizeof(int)) == 0);
+
+        BENCHMARK("spsc enqueue / dequeue") {
+            int data = 10, buf;
+            spsc_enqueue(&s, &data);
+            return spsc_dequeue(&s, &buf);
+        };
+
+        BENCHMARK("michael-scott enqueue / dequeue") {
+            int data = 10, buf;
+            queue_enqueue(&q, &data);
+            return queue_dequeue(&q, &buf);
+        };
+
+        queue_destroy(&q);
+        spsc_destroy(&s);
+    }
+}
+
+/**
+ *  Moves @c count values from a producer thread to the calling thread.
+ */
+static void run_transfer(int count,
+                         std::function<int(int *)> enqueue,
+                         std::function<void()> flush,
+                         std::function<int(int *)> dequeue)
+{
+    std::thread producer([=] {
+        for (int i = 0; i < count; ++i) {
+            while (enqueue(&i) != 0) {
+                sched_yield();
+            }
+        }
+        flush();
+    });
+    for (int i = 0; i < count; ) {
+        int buf;
+        if (dequeue(&buf) == 0) {
+            ++i;
+        } else {
+            sched_yield();
+        }
+    }
+    producer.join();
+}
+
+SCENARIO("1 生産者/1 消費者で SPSC リングと Michael-Scott キューを比較する",
+         tags(".", "benchmark", "spsc_create", "parallel")) {
+
+    static const int COUNT = 100000;
+
+    GIVEN("キューを作成する") {
+        spsc_t s1, s32;
+        queue_t q;
+
+        REQUIRE(spsc_create(&s1, sizeof(int), 1024, 1) == 0);
+        REQUIRE(spsc_create(&s32, sizeof(int), 1024, 32) == 0);
+        REQUIRE(queue_create(&q, sizeof(int)) == 0);
+
+        BENCHMARK("spsc batch 1") {
+            run_transfer(COUNT,
+                         [&](int *v) { return spsc_enqueue(&s1, v); },
+                         [&]() { spsc_flush(&s1); },
+                         [&](int *v) { return spsc_dequeue(&s1, v); });
+        };
+        BENCHMARK("spsc batch 32") {
+            run_transfer(COUNT,
+                         [&](int *v) { return spsc_enqueue(&s32, v); },
+                         [&]() { spsc_flush(&s32); },
+                         [&](int *v) { return spsc_dequeue(&s32, v); });
+        };
+        BENCHMARK("michael-scott") {
+            run_transfer(COUNT,
+                         [&](int *v) { return queue_enqueue(&q, v); },
+                         [&]() {},
+                         [&](int *v) { return queue_dequeue(&q, v); });
+        };
+
+        queue_destroy(&q);
+        spsc_destroy(&s32);
+        spsc_destroy(&s1);
+    }
+}
@@ -0,0 +1,177 @@
+/** @file       spsc_test.cpp
+ *  @brief      Unit-test for Single-producer/single-consumer ring.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <sched.h>
+#include <pthread.h>
+#include <catch2/catch.hpp>
+
+#include "utils.hpp"
+
+#include "spsc.h"
+
+extern "C" {
+#include "debug.h"
+}
+
+SCENARIO("キューを作成できること", tags("spsc", "spsc_create", "spsc_destroy")) {
+
+    GIVEN("特になし") {
+
+        WHEN("キューを作成する") {
+            spsc_t q;
+
+            THEN("キューが作成できること") {
+                REQUIRE(spsc_create(&q, sizeof(int), 100, 1) == 0);
+                CHECK(spsc_capacity(&q) == 128);
+                spsc_destroy(&q);
+            }
+        }
+
+        WHEN("容量 0 またはバッチ 0 でキューを作成する") {
+            spsc_t q;
+
+            THEN("作成に失敗すること") {
+                CHECK(spsc_create(&q, sizeof(int), 0, 1) == -1);
+                CHECK(errno == EINVAL);
+                CHECK(spsc_create(&q, sizeof(int), 16, 0) == -1);
+                CHECK(errno == EINVAL);
+            }
+        }
+    }
+}
+
+SCENARIO("キューにデータを追加/取得できること", tags("spsc", "spsc_enqueue", "spsc_dequeue")) {
+
+    GIVEN("キューを作成する") {
+        spsc_t q;
+
+        REQUIRE(spsc_create(&q, sizeof(int), 4, 1) == 0);
+
+        WHEN("空のキューから取得する") {
+
+            THEN("取得に失敗すること") {
+                int buf;
+                CHECK(spsc_dequeue(&q, &buf) == -1);
+                CHECK(errno == ENOENT);
+            }
+        }
+
+        WHEN("容量を超えてデータを追加する") {
+            int data[]{10, 20, 30, 40, 50};
+
+            INFO("データ: " + array_to_string(data));
+
+            THEN("容量までのデータが追加した順に取得できること") {
+                CHECK(spsc_enqueue(&q, &data[0]) == 0);
+                CHECK(spsc_enqueue(&q, &data[1]) == 0);
+                CHECK(spsc_enqueue(&q, &data[2]) == 0);
+                CHECK(spsc_enqueue(&q, &data[3]) == 0);
+                CHECK(spsc_enqueue(&q, &data[4]) == -1);
+                CHECK(errno == ENOMEM);
+
+                int buf;
+                CHECK((spsc_dequeue(&q, &buf)?:buf) == data[0]);
+                CHECK(spsc_enqueue(&q, &data[4]) == 0);
+                CHECK((spsc_dequeue(&q, &buf)?:buf) == data[1]);
+                CHECK((spsc_dequeue(&q, &buf)?:buf) == data[2]);
+                CHECK((spsc_dequeue(&q, &buf)?:buf) == data[3]);
+                CHECK((spsc_dequeue(&q, &buf)?:buf) == data[4]);
+                CHECK(spsc_dequeue(&q, &buf) == -1);
+            }
+        }
+
+        spsc_destroy(&q);
+    }
+}
+
+SCENARIO("まとめて公開されたデータが取得できること", tags("spsc", "spsc_enqueue", "spsc_flush")) {
+
+    GIVEN("バッチ 4 のキューを作成する") {
+        spsc_t q;
+
+        REQUIRE(spsc_create(&q, sizeof(int), 16, 4) == 0);
+
+        WHEN("バッチに満たない数のデータを追加する") {
+            int data[]{10, 20, 30};
+            for (auto d: data) {
+                REQUIRE(spsc_enqueue(&q, &d) == 0);
+            }
+
+            THEN("フラッシュするまで取得できないこと") {
+                int buf;
+                CHECK(spsc_dequeue(&q, &buf) == -1);
+                CHECK(spsc_flush(&q) == 0);
+                CHECK((spsc_dequeue(&q, &buf)?:buf) == data[0]);
+                CHECK((spsc_dequeue(&q, &buf)?:buf) == data[1]);
+                CHECK((spsc_dequeue(&q, &buf)?:buf) == data[2]);
+            }
+        }
+
+        WHEN("バッチ分のデータを追加する") {
+            int data[]{10, 20, 30, 40};
+            for (auto d: data) {
+                REQUIRE(spsc_enqueue(&q, &d) == 0);
+            }
+
+            THEN("フラッシュせずに取得できること") {
+                int buf;
+                CHECK((spsc_dequeue(&q, &buf)?:buf) == data[0]);
+            }
+        }
+
+        spsc_destroy(&q);
+    }
+}
+
+SCENARIO("生産者と消費者が並行してアクセスできること",
+         tags("spsc", "spsc_enqueue", "spsc_dequeue", "parallel")) {
+
+    for (size_t batch: {1, 16}) {
+
+        GIVEN("バッチ " + std::to_string(batch) + " の容量の小さいキューを作成する") {
+            spsc_t q;
+
+            REQUIRE(spsc_create(&q, sizeof(int), 64, batch) == 0);
+
+            WHEN("生産者スレッドから追加し、消費者スレッドで取得する") {
+                static const int TEST_COUNT = 100000;
+
+                auto producer = [&](void *) -> void * {
+                    for (int i = 0; i < TEST_COUNT; ++i) {
+                        while (spsc_enqueue(&q, &i) != 0) {
+                            sched_yield();
+                        }
+                    }
+                    spsc_flush(&q);
+                    return NULL;
+                };
+                pthread_t thr;
+                REQUIRE(pthread_create(&thr, NULL, Lambda::ptr<void *, void *>(producer), NULL) == 0);
+
+                THEN("追加した順にすべて取得できること") {
+                    int mismatches = 0;
+                    for (int expected = 0; expected < TEST_COUNT; ) {
+                        int buf;
+                        if (spsc_dequeue(&q, &buf) != 0) {
+                            sched_yield();
+                            continue;
+                        }
+                        if (buf != expected++) {
+                            ++mismatches;
+                        }
+                    }
+                    CHECK(mismatches == 0);
+                    REQUIRE(pthread_join(thr, NULL) == 0);
+                }
+            }
+
+            spsc_destroy(&q);
+        }
+    }
+}
@@ -12,21 +12,27 @@
  *
  *  This code is licensed under the MIT License.
  */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdatomic.h>
 #include <stdint.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 #include <sys/types.h>
+#include <sys/eventfd.h>
 
 #include "aux.h"
 #include "debug.h"
 #include "atomic.h"
 #include "queue.h"
 
+#define QUEUE_WAIT_SPINS 128
+
 typedef struct node {
     pointer_t next;
     uint8_t value[];
@@ -45,26 +51,236 @@ static inline size_t node_byte_aligned(size_t value_bytes)
 
 static inline bool CAS(pointer_t *a, pointer_t b, pointer_t c)
 {
-    return atomic_compare_exchange_weak(a, &b, c);
+    return atomic_dw_cas(a, &b, c);
 }
 
+/**
+ *  Adds node pool @c k, twice as large as pool k-1, once all the pools
+ *  before it have run dry.
+ *
+ *  @return Returns true if pool @c k exists now (added here or by another
+ *          thread), false if the queue may not grow any further.
+ */
+static bool queue_grow(queue_t *self, size_t k)
+{
+    if ((k >= QUEUE_POOLS_MAX) || (self->prealloc > (SIZE_MAX >> k))) {
+        return false;
+    }
+    size_t nodes = self->prealloc << k;
+    if (self->limit != 0) {
+        size_t total = 0;
+        for (size_t i = 0; i < k; ++i) {
+            total += mempool_capacity(self->pools[i]);
+        }
+        if (total >= self->limit) {
+            return false;
+        }
+        if (nodes > self->limit - total) {
+            nodes = self->limit - total;
+        }
+    }
+
+    mpool_t *mine = aligned_alloc(alignof(mpool_t), sizeof(*mine));
+    if (mine == NULL) {
+        return false;
+    }
+    if (mempool_create(mine, node_byte_aligned(self->value_bytes), nodes) != 0) {
+        free(mine);
+        return false;
+    }
+    mpool_t *pool = NULL;
+    if (!atomic_compare_exchange_strong(&self->pools[k], &pool, mine)) {
+        mempool_destroy(mine);
+        free(mine);
+    }
+    atomic_compare_exchange_strong(&self->npools, &k, k + 1);
+    return true;
+}
+
+/**
+ *  Takes a node from the first pool that has one. When all of them are
+ *  in use, reclaims the retired nodes first and grows the pools only if
+ *  none could be, so the system allocator is reached only for nodes that
+ *  are really held. Must be called outside smr_enter()/smr_leave().
+ */
 static inline node_t *new_node(queue_t *self)
 {
-    node_t *node = calloc(1, sizeof(node_t) + self->value_bytes);
-    return node;
+    while (true) {
+        size_t n = atomic_load(&self->npools);
+        for (size_t k = 0; k < n; ++k) {
+            node_t *node = mempool_alloc(self->pools[k]);
+            if (node != NULL) {
+                return node;
+            }
+        }
+        if ((smr_collect(&self->smr) == 0) && !queue_grow(self, n)) {
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
 }
 
-int queue_create(queue_t *q, size_t value_bytes)
+/**
+ *  Returns @c node to its pool once no operation can still be reading it.
+ */
+static void free_node(void *ptr, void *arg)
+{
+    queue_t *self = (queue_t *)arg;
+    size_t n = atomic_load(&self->npools);
+    for (size_t k = 0; k < n; ++k) {
+        if (mempool_contains(self->pools[k], ptr)) {
+            mempool_free(self->pools[k], ptr);
+            return;
+        }
+    }
+}
+
+/**
+ *  Reads @c *src and, with hazard pointers, publishes the node it names in
+ *  @c slot until @c *src is seen unchanged.
+ */
+static inline pointer_t load_protected(queue_t *self, struct smr_record *r,
+                                       int slot, pointer_t *src)
+{
+    pointer_t p = atomic_dw_load(src);
+    if (self->smr.scheme == SMR_HAZARD) {
+        while (true) {
+            smr_protect(&self->smr, r, slot, p.ptr);
+            pointer_t again = atomic_dw_load(src);
+            if ((again.ptr == p.ptr) && (again.count == p.count)) {
+                break;
+            }
+            p = again;
+        }
+    }
+    return p;
+}
+
+/**
+ *  Reports a crossing of the high or low mark at @c size, once per
+ *  crossing: only the thread that flips @c above calls back.
+ */
+static inline void watermark_check(queue_t *self, size_t size)
+{
+    if (self->watermark == NULL) {
+        return;
+    }
+    bool above = atomic_load_explicit(&self->above, memory_order_relaxed);
+    if (!above && (size >= self->high)) {
+        if (atomic_compare_exchange_strong(&self->above, &above, true)) {
+            self->watermark(self, QUEUE_WATERMARK_HIGH, self->watermark_arg);
+        }
+    } else if (above && (size <= self->low)) {
+        if (atomic_compare_exchange_strong(&self->above, &above, false)) {
+            self->watermark(self, QUEUE_WATERMARK_LOW, self->watermark_arg);
+        }
+    }
+}
+
+/**
+ *  Claims room for @c n values before they are linked, so that the size
+ *  never runs below the nodes actually in the list.
+ *
+ *  @return Returns true if claimed, false if a bounded queue has no room.
+ */
+static inline bool queue_reserve(queue_t *self, size_t n)
+{
+    size_t size;
+    if (self->capacity == 0) {
+        size = atomic_fetch_add(&self->size, n) + n;
+    } else {
+        size = atomic_load(&self->size);
+        do {
+            if (n > self->capacity - size) {
+                return false;
+            }
+        } while (!atomic_compare_exchange_weak(&self->size, &size, size + n));
+        size += n;
+    }
+    watermark_check(self, size);
+    return true;
+}
+
+/**
+ *  queue_reserve() that sleeps on @c space while a bounded queue is full.
+ */
+static bool queue_reserve_wait(queue_t *self, size_t n)
 {
-    if ((q == NULL) || (value_bytes == 0)) {
+    for (int i = 0; i < QUEUE_WAIT_SPINS; ++i) {
+        if (queue_reserve(self, n)) {
+            return true;
+        }
+        cpu_relax();
+    }
+    while (true) {
+        uint32_t key = eventcount_prepare(&self->space);
+        if (queue_reserve(self, n)) {
+            eventcount_cancel(&self->space);
+            return true;
+        }
+        eventcount_wait(&self->space, key, NULL);
+    }
+}
+
+/**
+ *  Gives back the room of @c n values dequeued or never linked.
+ */
+static inline void queue_release(queue_t *self, size_t n)
+{
+    size_t size = atomic_fetch_sub(&self->size, n) - n;
+    watermark_check(self, size);
+    if (self->capacity != 0) {
+        eventcount_notify_n(&self->space, (n < INT_MAX) ? (int)n : INT_MAX);
+    }
+}
+
+/**
+ *  Writes the eventfd, once until the consumer acknowledges it.
+ */
+static inline void queue_signal(queue_t *self)
+{
+    if ((self->efd < 0) || atomic_load(&self->signaled)
+        || atomic_exchange(&self->signaled, true)) {
+        return;
+    }
+    uint64_t one = 1;
+    UNUSED_VARIABLE(write(self->efd, &one, sizeof(one)));
+}
+
+static int queue_init(queue_t *q, size_t value_bytes, size_t prealloc,
+                      size_t limit, size_t capacity, unsigned int flags)
+{
+    if ((q == NULL) || (value_bytes == 0) || (prealloc == 0)) {
         errno = EINVAL;
         return -1;
     }
 
     q->value_bytes = value_bytes;
     atomic_store(&q->size, 0);
+    q->above = false;
+    q->capacity = capacity;
+    q->high = q->low = 0;
+    q->watermark = NULL;
+    q->watermark_arg = NULL;
+    eventcount_init(&q->ready);
+    eventcount_init(&q->space);
+    q->signaled = false;
+    q->efd = -1;
+    memset(q->pools, 0, sizeof(q->pools));
+    q->npools = 0;
+    q->prealloc = prealloc;
+    q->limit = limit;
+    smr_init(&q->smr, (flags & QUEUE_FLAG_EPOCH) ? SMR_EPOCH : SMR_HAZARD, free_node, q);
+    if (flags & QUEUE_FLAG_EVENTFD) {
+        q->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (q->efd < 0) {
+            queue_destroy(q);
+            return -1;
+        }
+    }
     node_t *node = new_node(q);
     if (node == NULL) {
+        queue_destroy(q);
         return -1;
     }
     node->next.ptr = NULL;
@@ -74,6 +290,52 @@ int queue_create(queue_t *q, size_t value_bytes)
     return 0;
 }
 
+int queue_create(queue_t *q, size_t value_bytes)
+{
+    return queue_init(q, value_bytes, QUEUE_PREALLOC_DEFAULT, 0, 0, 0);
+}
+
+int queue_create_pooled(queue_t *q, size_t value_bytes, size_t prealloc, size_t limit)
+{
+    return queue_init(q, value_bytes, prealloc, limit, 0, 0);
+}
+
+int queue_create_flags(queue_t *q, size_t value_bytes, unsigned int flags)
+{
+    return queue_init(q, value_bytes, QUEUE_PREALLOC_DEFAULT, 0, 0, flags);
+}
+
+int queue_create_bounded(queue_t *q, size_t value_bytes, size_t capacity)
+{
+    if (capacity == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t prealloc = (capacity < QUEUE_PREALLOC_DEFAULT) ? capacity : QUEUE_PREALLOC_DEFAULT;
+    /* the dummy node takes one more. */
+    return queue_init(q, value_bytes, prealloc + 1, 0, capacity, 0);
+}
+
+int queue_set_watermarks(queue_t *q, size_t high, size_t low,
+                         queue_watermark_fn fn, void *arg)
+{
+    if ((q == NULL)
+        || ((fn != NULL)
+            && ((low >= high) || ((q->capacity != 0) && (high > q->capacity))))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    q->high = high;
+    q->low = low;
+    q->watermark_arg = arg;
+    q->above = false;
+    q->watermark = fn;
+
+    return 0;
+}
+
 int queue_destroy(queue_t *q)
 {
     if (q == NULL) {
@@ -81,34 +343,51 @@ int queue_destroy(queue_t *q)
         return -1;
     }
 
-    pointer_t curr, next;
-    for (curr = atomic_load(&q->Head); curr.ptr != NULL; curr = next) {
-        next = curr.ptr->next;
-        free(curr.ptr);
+    smr_destroy(&q->smr);
+    if (q->efd >= 0) {
+        close(q->efd);
+        q->efd = -1;
     }
+    for (size_t k = 0; k < q->npools; ++k) {
+        mempool_destroy(q->pools[k]);
+        free(q->pools[k]);
+        q->pools[k] = NULL;
+    }
+    q->npools = 0;
 
     return 0;
 }
 
-int queue_enqueue(queue_t *q, const void *value)
+static int queue_put(queue_t *q, const void *value, bool wait)
 {
     if ((q == NULL) || (value == NULL)) {
         errno = EINVAL;
         return -1;
     }
 
+    if (!queue_reserve(q, 1) && (!wait || !queue_reserve_wait(q, 1))) {
+        errno = EAGAIN;
+        return -1;
+    }
     node_t *node = new_node(q);
     if (node == NULL) {
+        queue_release(q, 1);
         return -1;
     }
     memcpy(node->value, value, q->value_bytes);
     node->next.ptr = NULL;
+    struct smr_record *r = smr_enter(&q->smr);
+    if (r == NULL) {
+        free_node(node, q);
+        queue_release(q, 1);
+        return -1;
+    }
     pointer_t tail, next;
     while (true) {
-        tail = atomic_load(&q->Tail);
-        next = tail.ptr->next;
-        if ((tail.ptr == atomic_load(&q->Tail).ptr)
-            && (tail.count == atomic_load(&q->Tail).count)) {
+        tail = load_protected(q, r, 0, &q->Tail);
+        next = atomic_dw_load(&tail.ptr->next);
+        if ((tail.ptr == atomic_dw_load(&q->Tail).ptr)
+            && (tail.count == atomic_dw_load(&q->Tail).count)) {
             if (next.ptr == NULL) {
                 if (CAS(&tail.ptr->next, next,
                         ((pointer_t){node, next.count+1}))) {
@@ -121,11 +400,23 @@ int queue_enqueue(queue_t *q, const void *value)
     }
 
     CAS(&q->Tail, tail, ((pointer_t){node, tail.count+1}));
-    atomic_inc(&q->size);
+    smr_leave(&q->smr, r);
+    eventcount_notify(&q->ready);
+    queue_signal(q);
 
     return 0;
 }
 
+int queue_enqueue(queue_t *q, const void *value)
+{
+    return queue_put(q, value, true);
+}
+
+int queue_try_enqueue(queue_t *q, const void *value)
+{
+    return queue_put(q, value, false);
+}
+
 int queue_dequeue(queue_t *q, void *value)
 {
     if ((q == NULL) || (value == NULL)) {
@@ -133,15 +424,21 @@ int queue_dequeue(queue_t *q, void *value)
         return -1;
     }
 
+    struct smr_record *r = smr_enter(&q->smr);
+    if (r == NULL) {
+        return -1;
+    }
     pointer_t head, tail, next;
     while (true) {
-        head = atomic_load(&q->Head);
-        tail = atomic_load(&q->Tail);
-        next = head.ptr->next;
-        if ((head.ptr == atomic_load(&q->Head).ptr)
-            && (head.count == atomic_load(&q->Head).count)) {
+        head = load_protected(q, r, 0, &q->Head);
+        tail = atomic_dw_load(&q->Tail);
+        next = atomic_dw_load(&head.ptr->next);
+        smr_protect(&q->smr, r, 1, next.ptr);
+        if ((head.ptr == atomic_dw_load(&q->Head).ptr)
+            && (head.count == atomic_dw_load(&q->Head).count)) {
             if (head.ptr == tail.ptr) {
                 if (next.ptr == NULL) {
+                    smr_leave(&q->smr, r);
                     errno = ENOENT;
                     return -1;
                 }
@@ -156,8 +453,217 @@ int queue_dequeue(queue_t *q, void *value)
         }
     }
 
-    free(head.ptr);
-    atomic_dec(&q->size);
+    smr_retire(&q->smr, r, head.ptr);
+    smr_leave(&q->smr, r);
+    queue_release(q, 1);
+
+    return 0;
+}
+
+int queue_enqueue_n(queue_t *q, const void *values, size_t n)
+{
+    if ((q == NULL) || (values == NULL) || (n == 0)
+        || ((q->capacity != 0) && (n > q->capacity))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (!queue_reserve(q, n)) {
+        queue_reserve_wait(q, n);
+    }
+    /* build the chain privately; nobody can see it until it is linked. */
+    node_t *first = NULL, *last = NULL;
+    for (size_t i = 0; i < n; ++i) {
+        node_t *node = new_node(q);
+        if (node == NULL) {
+            while (first != NULL) {
+                node_t *next = first->next.ptr;
+                free_node(first, q);
+                first = next;
+            }
+            queue_release(q, n);
+            return -1;
+        }
+        memcpy(node->value, (const uint8_t *)values + (q->value_bytes * i), q->value_bytes);
+        node->next.ptr = NULL;
+        if (last == NULL) {
+            first = node;
+        } else {
+            last->next.ptr = node;
+        }
+        last = node;
+    }
+    struct smr_record *r = smr_enter(&q->smr);
+    if (r == NULL) {
+        while (first != NULL) {
+            node_t *next = first->next.ptr;
+            free_node(first, q);
+            first = next;
+        }
+        queue_release(q, n);
+        return -1;
+    }
+    pointer_t tail, next;
+    while (true) {
+        tail = load_protected(q, r, 0, &q->Tail);
+        next = atomic_dw_load(&tail.ptr->next);
+        if ((tail.ptr == atomic_dw_load(&q->Tail).ptr)
+            && (tail.count == atomic_dw_load(&q->Tail).count)) {
+            if (next.ptr == NULL) {
+                if (CAS(&tail.ptr->next, next,
+                        ((pointer_t){first, next.count+1}))) {
+                    break;
+                }
+            } else {
+                CAS(&q->Tail, tail, ((pointer_t){next.ptr, tail.count+1}));
+            }
+        }
+    }
+
+    /*
+     *  Swing Tail straight to the end of the chain. If another thread got
+     *  there first, it walks Tail over the chain one node at a time.
+     */
+    CAS(&q->Tail, tail, ((pointer_t){last, tail.count+1}));
+    smr_leave(&q->smr, r);
+    eventcount_notify_n(&q->ready, (n < INT_MAX) ? (int)n : INT_MAX);
+    queue_signal(q);
+
+    return 0;
+}
+
+ssize_t queue_dequeue_n(queue_t *q, void *values, size_t n)
+{
+    if ((q == NULL) || (values == NULL) || (n == 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct smr_record *r = smr_enter(&q->smr);
+    if (r == NULL) {
+        return -1;
+    }
+    uint8_t *dst = (uint8_t *)values;
+    pointer_t head, tail, next;
+    node_t *last;
+    size_t count;
+    while (true) {
+        head = load_protected(q, r, 0, &q->Head);
+        tail = atomic_dw_load(&q->Tail);
+        next = atomic_dw_load(&head.ptr->next);
+        smr_protect(&q->smr, r, 1, next.ptr);
+        if ((head.ptr != atomic_dw_load(&q->Head).ptr)
+            || (head.count != atomic_dw_load(&q->Head).count)) {
+            continue;
+        }
+        if (head.ptr == tail.ptr) {
+            if (next.ptr == NULL) {
+                smr_leave(&q->smr, r);
+                errno = ENOENT;
+                return -1;
+            }
+            CAS(&q->Tail, tail, ((pointer_t){next.ptr, tail.count+1}));
+            continue;
+        }
+
+        /*
+         *  Copy out values up to the Tail seen above; Head must never pass
+         *  Tail. Each node is protected hand over hand. While Head is
+         *  unchanged, every node behind it is still linked and so still
+         *  safe to read.
+         */
+        bool moved = false;
+        node_t *node = next.ptr;
+        count = 0;
+        while (true) {
+            memcpy(&dst[q->value_bytes * count++], node->value, q->value_bytes);
+            last = node;
+            if ((count == n) || (node == tail.ptr)) {
+                break;
+            }
+            node_t *succ = atomic_dw_load(&node->next).ptr;
+            if (succ == NULL) {
+                break;
+            }
+            smr_protect(&q->smr, r, 1 + (count & 1), succ);
+            if ((head.ptr != atomic_dw_load(&q->Head).ptr)
+                || (head.count != atomic_dw_load(&q->Head).count)) {
+                moved = true;
+                break;
+            }
+            node = succ;
+        }
+        if (!moved && CAS(&q->Head, head, ((pointer_t){last, head.count+1}))) {
+            break;
+        }
+    }
+
+    /* the old dummy and every node consumed but the last, the new dummy. */
+    for (node_t *node = head.ptr; node != last; ) {
+        node_t *succ = node->next.ptr;
+        smr_retire(&q->smr, r, node);
+        node = succ;
+    }
+    smr_leave(&q->smr, r);
+    queue_release(q, count);
+
+    return (ssize_t)count;
+}
+
+int queue_dequeue_wait(queue_t *q, void *value, int timeout_ms)
+{
+    if ((q == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (int i = 0; i < QUEUE_WAIT_SPINS; ++i) {
+        if (queue_dequeue(q, value) == 0) {
+            return 0;
+        }
+        cpu_relax();
+    }
+
+    struct timespec ts, *deadline = eventcount_deadline(timeout_ms, &ts);
+    while (true) {
+        uint32_t key = eventcount_prepare(&q->ready);
+        if (queue_dequeue(q, value) == 0) {
+            eventcount_cancel(&q->ready);
+            return 0;
+        }
+        if (eventcount_wait(&q->ready, key, deadline) != 0) {
+            if (queue_dequeue(q, value) == 0) {
+                return 0;
+            }
+            errno = ETIMEDOUT;
+            return -1;
+        }
+    }
+}
+
+int queue_eventfd(queue_t *q)
+{
+    if ((q == NULL) || (q->efd < 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return q->efd;
+}
+
+int queue_eventfd_ack(queue_t *q)
+{
+    if ((q == NULL) || (q->efd < 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint64_t count;
+    if ((read(q->efd, &count, sizeof(count)) < 0) && (errno != EAGAIN)) {
+        return -1;
+    }
+    /* from here on the next enqueue writes again. */
+    atomic_store(&q->signaled, false);
 
     return 0;
 }
@@ -173,7 +679,7 @@ void *queue_to_array(queue_t *q)
     size_t size = q->value_bytes;
     uint8_t *ptr = calloc(n, size);
     int i = 0;
-    for (pointer_t curr = atomic_load(&q->Head); curr.ptr != NULL; curr = curr.ptr->next, ++i) {
+    for (pointer_t curr = atomic_dw_load(&q->Head); curr.ptr != NULL; curr = curr.ptr->next, ++i) {
         pointer_t next = curr.ptr->next;
         if (next.ptr != NULL) {
 printf("  [%d]: %d\n", i, *(int *)next.ptr->value);
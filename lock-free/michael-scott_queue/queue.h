@@ -15,27 +15,117 @@
 #ifndef __ALGORITHMS_INTERNAL_QUEUE_H__
 #define __ALGORITHMS_INTERNAL_QUEUE_H__
 
+#include <sys/types.h>
+
+#include "eventcount.h"
+#include "mempool.h"
+#include "smr.h"
+
 #if defined(__cplusplus)
 extern "C" {
 #endif
 
 struct node;
 
+/* node pools: pools[k] holds (prealloc << k) nodes. */
+#define QUEUE_POOLS_MAX 32
+#define QUEUE_PREALLOC_DEFAULT 64
+
+/* reclaim dequeued nodes with epochs instead of hazard pointers. */
+#define QUEUE_FLAG_EPOCH (1U << 0)
+/* signal an eventfd when the queue turns non-empty, see queue_eventfd(). */
+#define QUEUE_FLAG_EVENTFD (1U << 1)
+
+/* marks passed to a queue_watermark_fn. */
+#define QUEUE_WATERMARK_HIGH 1
+#define QUEUE_WATERMARK_LOW  0
+
+struct queue;
+
+/*
+ *  Called on the thread whose enqueue brought the size up to the high mark,
+ *  or whose dequeue brought it back down to the low mark. Each crossing is
+ *  reported once, HIGH and LOW alternate.
+ */
+typedef void (*queue_watermark_fn)(struct queue *q, int mark, void *arg);
+
 typedef struct pointer {
-    struct node *ptr;
-    uint32_t count;
+    alignas(16) struct node *ptr;
+    uintptr_t count;
 } pointer_t;
 
 typedef struct queue {
-    alignas(16) struct pointer Head, Tail;
-    size_t value_bytes;
-    size_t size;
+    /* consumer side. */
+    alignas(CACHE_LINE_BYTES) struct pointer Head;
+    /* producer side. */
+    alignas(CACHE_LINE_BYTES) struct pointer Tail;
+    /* written by both sides. */
+    alignas(CACHE_LINE_BYTES) size_t size;   /* counts enqueues in flight too. */
+    bool above;                 /* past the high mark, not yet back to low. */
+    bool signaled;              /* efd written, not yet acknowledged. */
+    /* read-mostly. */
+    alignas(CACHE_LINE_BYTES) size_t value_bytes;
+    size_t prealloc;
+    size_t limit;               /* most nodes the pools may hold, 0 for no limit. */
+    size_t npools;
+    mpool_t *pools[QUEUE_POOLS_MAX];
+    size_t capacity;            /* most values held at once, 0 for no limit. */
+    size_t high;
+    size_t low;
+    queue_watermark_fn watermark;
+    void *watermark_arg;
+    int efd;                    /* QUEUE_FLAG_EVENTFD, -1 otherwise. */
+    struct eventcount ready;    /* queue_dequeue_wait() sleepers. */
+    struct eventcount space;    /* queue_enqueue() sleepers on a full queue. */
+    struct smr_domain smr;      /* dequeued nodes wait here until unreachable. */
 } queue_t;
 
 int queue_create(queue_t *q, size_t value_bytes);
+/*
+ *  queue_create() with the node pool sized explicitly: prealloc nodes are
+ *  allocated up front and the pool doubles whenever it runs dry, up to
+ *  limit nodes in all (0: no limit). Enqueue fails with ENOMEM beyond it.
+ */
+int queue_create_pooled(queue_t *q, size_t value_bytes, size_t prealloc, size_t limit);
+int queue_create_flags(queue_t *q, size_t value_bytes, unsigned int flags);
+/*
+ *  queue_create() that holds at most capacity values. queue_enqueue() and
+ *  queue_enqueue_n() sleep while full, queue_try_enqueue() fails with EAGAIN.
+ */
+int queue_create_bounded(queue_t *q, size_t value_bytes, size_t capacity);
+/*
+ *  Calls fn when the size reaches high and again when it falls back to low
+ *  (low < high, high no more than the capacity). fn NULL stops the calls.
+ *  Not to be called while other threads use the queue.
+ */
+int queue_set_watermarks(queue_t *q, size_t high, size_t low,
+                         queue_watermark_fn fn, void *arg);
 int queue_destroy(queue_t *q);
 int queue_enqueue(queue_t *q, const void *value);
+/* queue_enqueue() that fails with EAGAIN instead of sleeping while full. */
+int queue_try_enqueue(queue_t *q, const void *value);
 int queue_dequeue(queue_t *q, void *value);
+/*
+ *  Enqueues n values laid out back to back, linked to the tail with a
+ *  single CAS. Either all of them are enqueued or none. On a bounded queue
+ *  it waits for room for all n; n beyond the capacity fails with EINVAL.
+ */
+int queue_enqueue_n(queue_t *q, const void *values, size_t n);
+/*
+ *  Dequeues up to n values into an array with a single CAS on Head.
+ *  Returns how many were dequeued, -1 with ENOENT while empty.
+ */
+ssize_t queue_dequeue_n(queue_t *q, void *values, size_t n);
+/* queue_dequeue() that sleeps while empty, up to timeout_ms (-1: forever). */
+int queue_dequeue_wait(queue_t *q, void *value, int timeout_ms);
+/*
+ *  The eventfd of a QUEUE_FLAG_EVENTFD queue, for an epoll set. It turns
+ *  readable once after queue_eventfd_ack(), on the first enqueue; enqueues
+ *  into a signaled queue make no syscall. A consumer acknowledges, then
+ *  dequeues until ENOENT, in that order, so no enqueue goes unsignaled.
+ */
+int queue_eventfd(queue_t *q);
+int queue_eventfd_ack(queue_t *q);
 void *queue_to_array(queue_t *q);
 
 #if defined(__cplusplus)
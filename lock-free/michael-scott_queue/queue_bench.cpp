@@ -0,0 +1,283 @@
+/** @file       queue_bench.cpp
+ *  @brief      Benchmark for Queue.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "queue.h"
+
+SCENARIO("キューの操作コストを計測する", tags(".", "benchmark", "queue_enqueue", "queue_dequeue")) {
+
+    GIVEN("キューを作成する") {
+        queue_t q;
+
+        REQUIRE(queue_create(&q, sizeof(int)) == 0);
+
+        BENCHMARK("enqueue / dequeue") {
+            int data = 10, buf;
+            queue_enqueue(&q, &data);
+            return queue_dequeue(&q, &buf);
+        };
+
+        queue_destroy(&q);
+    }
+}
+
+SCENARIO("まとめての追加/取得のコストを計測する",
+         tags(".", "benchmark", "queue_enqueue_n", "queue_dequeue_n")) {
+
+    static const int BATCH = 16;
+
+    GIVEN("キューを作成する") {
+        queue_t q;
+
+        REQUIRE(queue_create(&q, sizeof(int)) == 0);
+
+        BENCHMARK(std::to_string(BATCH) + " x enqueue / dequeue") {
+            int data[BATCH]{}, buf[BATCH];
+            for (int i = 0; i < BATCH; ++i) {
+                queue_enqueue(&q, &data[i]);
+            }
+            for (int i = 0; i < BATCH; ++i) {
+                queue_dequeue(&q, &buf[i]);
+            }
+            return buf[BATCH - 1];
+        };
+
+        BENCHMARK("enqueue_n / dequeue_n " + std::to_string(BATCH)) {
+            int data[BATCH]{}, buf[BATCH];
+            queue_enqueue_n(&q, data, BATCH);
+            return queue_dequeue_n(&q, buf, BATCH);
+        };
+
+        queue_destroy(&q);
+    }
+}
+
+SCENARIO("容量の有無による追加/取得のコストを計測する",
+         tags(".", "benchmark", "queue_create_bounded", "queue_try_enqueue")) {
+
+    GIVEN("容量なし/容量ありのキューを作成する") {
+        queue_t unbounded, bounded;
+
+        REQUIRE(queue_create(&unbounded, sizeof(int)) == 0);
+        REQUIRE(queue_create_bounded(&bounded, sizeof(int), 1024) == 0);
+
+        BENCHMARK("unbounded enqueue / dequeue") {
+            int data = 10, buf;
+            queue_enqueue(&unbounded, &data);
+            return queue_dequeue(&unbounded, &buf);
+        };
+
+        BENCHMARK("bounded try_enqueue / dequeue") {
+            int data = 10, buf;
+            queue_try_enqueue(&bounded, &data);
+            return queue_dequeue(&bounded, &buf);
+        };
+
+        queue_destroy(&bounded);
+        queue_destroy(&unbounded);
+    }
+}
+
+SCENARIO("eventfd 通知の有無による追加のコストを計測する",
+         tags(".", "benchmark", "queue_eventfd", "queue_enqueue")) {
+
+    GIVEN("通知なし/eventfd 通知のキューを作成する") {
+        queue_t plain, efd;
+
+        REQUIRE(queue_create(&plain, sizeof(int)) == 0);
+        REQUIRE(queue_create_flags(&efd, sizeof(int), QUEUE_FLAG_EVENTFD) == 0);
+
+        /* keep one value in each, so that the benchmarks measure the non-empty path. */
+        int data = 10, buf;
+        queue_enqueue(&plain, &data);
+        queue_enqueue(&efd, &data);
+
+        BENCHMARK("plain enqueue / dequeue") {
+            queue_enqueue(&plain, &data);
+            return queue_dequeue(&plain, &buf);
+        };
+
+        BENCHMARK("eventfd enqueue / dequeue") {
+            queue_enqueue(&efd, &data);
+            return queue_dequeue(&efd, &buf);
+        };
+
+        BENCHMARK("eventfd ack / enqueue / dequeue") {
+            queue_eventfd_ack(&efd);
+            queue_enqueue(&efd, &data);
+            return queue_dequeue(&efd, &buf);
+        };
+
+        queue_destroy(&efd);
+        queue_destroy(&plain);
+    }
+}
+
+/**
+ *  Runs @c threads threads, each doing @c ops balanced enqueue/dequeue pairs.
+ */
+static void run_balanced(queue_t *q, int threads, int ops)
+{
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([=] {
+            int data = t, buf;
+            for (int i = 0; i < ops; ++i) {
+                queue_enqueue(q, &data);
+                queue_dequeue(q, &buf);
+            }
+        });
+    }
+    for (auto &w: workers) {
+        w.join();
+    }
+}
+
+SCENARIO("キューの操作コストを回収方式/スレッド数ごとに計測する",
+         tags(".", "benchmark", "queue_create_flags", "queue_enqueue", "queue_dequeue", "parallel")) {
+
+    static const int OPS = 10000;
+
+    for (unsigned int flags: {0U, QUEUE_FLAG_EPOCH}) {
+        std::string name = (flags & QUEUE_FLAG_EPOCH) ? "epoch" : "hazard";
+
+        GIVEN(name + " で回収するキューを作成する") {
+            queue_t q;
+
+            REQUIRE(queue_create_flags(&q, sizeof(int), flags) == 0);
+
+            BENCHMARK(name + " enqueue / dequeue") {
+                int data = 10, buf;
+                queue_enqueue(&q, &data);
+                return queue_dequeue(&q, &buf);
+            };
+
+            for (int threads: {1, 2, 4, 8, 16}) {
+                BENCHMARK(name + " " + std::to_string(threads) + " threads") {
+                    run_balanced(&q, threads, OPS);
+                };
+            }
+
+            queue_destroy(&q);
+        }
+    }
+}
+
+static void discard(void *, void *)
+{
+}
+
+SCENARIO("SMR の retire/scan コストを計測する", tags(".", "benchmark", "smr")) {
+
+    static char nodes[SMR_RETIRE_BATCH * 4];
+
+    for (int scheme: {SMR_EPOCH, SMR_HAZARD}) {
+        std::string name = (scheme == SMR_HAZARD) ? "hazard" : "epoch";
+
+        GIVEN(name + " のドメインを作成する") {
+            struct smr_domain d;
+
+            REQUIRE(smr_init(&d, scheme, discard, NULL) == 0);
+
+            BENCHMARK(name + " enter / protect / leave") {
+                struct smr_record *r = smr_enter(&d);
+                void *p = smr_protect(&d, r, 0, &nodes[0]);
+                smr_leave(&d, r);
+                return p;
+            };
+
+            int i = 0;
+            BENCHMARK(name + " enter / retire / leave") {
+                struct smr_record *r = smr_enter(&d);
+                smr_retire(&d, r, &nodes[i++ % sizeof(nodes)]);
+                smr_leave(&d, r);
+                return r;
+            };
+
+            smr_destroy(&d);
+        }
+    }
+}
+
+/**
+ *  Two threads each bump their own counter in @c T, @c ops times.
+ */
+template <typename T>
+static void run_counters(int ops)
+{
+    T c;
+    c.a.store(0);
+    c.b.store(0);
+    std::thread other([&] {
+        for (int i = 0; i < ops; ++i) {
+            c.b.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    for (int i = 0; i < ops; ++i) {
+        c.a.fetch_add(1, std::memory_order_relaxed);
+    }
+    other.join();
+}
+
+struct packed_counters {
+    std::atomic<size_t> a;
+    std::atomic<size_t> b;
+};
+
+struct padded_counters {
+    alignas(CACHE_LINE_BYTES) std::atomic<size_t> a;
+    alignas(CACHE_LINE_BYTES) std::atomic<size_t> b;
+};
+
+SCENARIO("偽共有のコストを計測する",
+         tags(".", "benchmark", "false_sharing", "queue_enqueue", "queue_dequeue", "parallel")) {
+
+    static const int OPS = 100000;
+
+    GIVEN("同じ行/別の行に置いたカウンタ") {
+
+        BENCHMARK("packed counters") {
+            run_counters<packed_counters>(OPS);
+        };
+
+        BENCHMARK("padded counters") {
+            run_counters<padded_counters>(OPS);
+        };
+    }
+
+    GIVEN("キューを作成する") {
+        queue_t q;
+
+        REQUIRE(queue_create(&q, sizeof(int)) == 0);
+
+        BENCHMARK("producer / consumer " + std::to_string(OPS)) {
+            std::thread producer([&] {
+                for (int i = 0; i < OPS; ++i) {
+                    queue_enqueue(&q, &i);
+                }
+            });
+            int buf;
+            for (int i = 0; i < OPS; ) {
+                if (queue_dequeue(&q, &buf) == 0) {
+                    ++i;
+                }
+            }
+            producer.join();
+        };
+
+        queue_destroy(&q);
+    }
+}
@@ -0,0 +1,53 @@
+/** @file       queue_coro.hpp
+ *  @brief      C++20 awaitable wrapper for the queue.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __ALGORITHMS_INTERNAL_QUEUE_CORO_HPP__
+#define __ALGORITHMS_INTERNAL_QUEUE_CORO_HPP__
+
+#include "awaitable.hpp"
+#include "queue.h"
+
+namespace algorithms {
+
+struct queue_ops {
+    using container_type = queue_t;
+
+    /* capacity 0: unbounded, push never waits. */
+    static int create(queue_t *q, size_t value_bytes, size_t capacity)
+    {
+        return (capacity == 0) ? queue_create(q, value_bytes)
+                               : queue_create_bounded(q, value_bytes, capacity);
+    }
+
+    static int destroy(queue_t *q)
+    {
+        return queue_destroy(q);
+    }
+
+    static int try_push(queue_t *q, const void *value)
+    {
+        return retry_on(queue_try_enqueue(q, value), EAGAIN);
+    }
+
+    static int try_pop(queue_t *q, void *value)
+    {
+        return retry_on(queue_dequeue(q, value), ENOENT);
+    }
+};
+
+/**
+ *  FIFO channel: `co_await q.push(v)` waits while full,
+ *  `co_await q.pop()` while empty.
+ */
+template <typename T, typename Executor = inline_executor>
+using coro_queue = awaitable_channel<queue_ops, T, Executor>;
+
+} // namespace algorithms
+
+#endif /* __ALGORITHMS_INTERNAL_QUEUE_CORO_HPP__ */
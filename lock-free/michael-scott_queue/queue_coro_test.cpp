@@ -0,0 +1,410 @@
+/** @file       queue_coro_test.cpp
+ *  @brief      Unit-test for the queue awaitables (C++20).
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <coroutine>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "queue_coro.hpp"
+
+using algorithms::coro_queue;
+
+/**
+ *  Coroutine that starts right away and frees itself when done.
+ */
+struct detached {
+    struct promise_type {
+        detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/**
+ *  Holds the coroutines to resume until run() is called.
+ */
+struct deferred_executor {
+    std::vector<std::coroutine_handle<>> *pending;
+
+    void operator()(std::coroutine_handle<> h) const
+    {
+        pending->push_back(h);
+    }
+
+    void run() const
+    {
+        while (!pending->empty()) {
+            auto h = pending->front();
+            pending->erase(pending->begin());
+            h.resume();
+        }
+    }
+};
+
+template <typename Q>
+static detached pop_into(Q &q, int *out, std::atomic<int> *done)
+{
+    *out = co_await q.pop();
+    ++*done;
+}
+
+template <typename Q>
+static detached push_from(Q &q, int value, std::atomic<int> *done)
+{
+    co_await q.push(value);
+    ++*done;
+}
+
+SCENARIO("キューの追加/取得を co_await で待機できること",
+         tags("queue", "queue_coro", "coro_queue_push", "coro_queue_pop")) {
+
+    GIVEN("容量なしのキューを作成する") {
+        coro_queue<int> q(0);
+
+        WHEN("データがある状態で取得する") {
+            int data = 10;
+            REQUIRE(queue_enqueue(q.native(), &data) == 0);
+            int out = -1;
+            std::atomic<int> done{0};
+            pop_into(q, &out, &done);
+
+            THEN("中断せずにその場で取得できること") {
+                CHECK(done == 1);
+                CHECK(out == 10);
+            }
+        }
+
+        WHEN("空の状態で取得し、後から追加する") {
+            int out[2] = {-1, -1};
+            std::atomic<int> done{0};
+            pop_into(q, &out[0], &done);
+            pop_into(q, &out[1], &done);
+            CHECK(done == 0);
+
+            THEN("追加したスレッド上で待機順に再開されること") {
+                std::atomic<int> pushed{0};
+                push_from(q, 10, &pushed);
+                CHECK(done == 1);
+                CHECK(out[0] == 10);
+                push_from(q, 11, &pushed);
+                CHECK(done == 2);
+                CHECK(out[1] == 11);
+                CHECK(pushed == 2);
+            }
+        }
+    }
+
+    GIVEN("容量 1 のキューを作成する") {
+        coro_queue<int> q(1);
+
+        WHEN("満杯の状態で追加し、後から取得する") {
+            std::atomic<int> pushed{0}, popped{0};
+            push_from(q, 10, &pushed);
+            push_from(q, 11, &pushed);
+            CHECK(pushed == 1);
+
+            THEN("空きができたところで追加が再開されること") {
+                int out = -1;
+                pop_into(q, &out, &popped);
+                CHECK(out == 10);
+                CHECK(pushed == 2);
+                pop_into(q, &out, &popped);
+                CHECK(out == 11);
+                CHECK(popped == 2);
+            }
+        }
+    }
+
+    GIVEN("指定した executor で再開するキューを作成する") {
+        std::vector<std::coroutine_handle<>> pending;
+        deferred_executor ex{&pending};
+        coro_queue<int, deferred_executor> q(0, ex);
+
+        WHEN("空の状態で取得し、後から追加する") {
+            int out = -1;
+            std::atomic<int> done{0}, pushed{0};
+            pop_into(q, &out, &done);
+            push_from(q, 10, &pushed);
+
+            THEN("executor が実行するまで再開されないこと") {
+                CHECK(pushed == 1);
+                CHECK(done == 0);
+                CHECK(pending.size() == 1);
+                ex.run();
+                CHECK(done == 1);
+                CHECK(out == 10);
+            }
+        }
+    }
+}
+
+/**
+ *  Container whose pushes fail, first as full and then with EINVAL.
+ */
+struct failing_ops {
+    using container_type = int;
+
+    static int create(int *c, size_t, size_t)
+    {
+        *c = 0;
+        return 0;
+    }
+
+    static int destroy(int *)
+    {
+        return 0;
+    }
+
+    static int try_push(int *c, const void *)
+    {
+        errno = ((*c)++ == 0) ? EAGAIN : EINVAL;
+        return algorithms::retry_on(-1, EAGAIN);
+    }
+
+    static int try_pop(int *, void *)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+};
+
+template <typename Q>
+static detached push_catching(Q &q, int value, int *err)
+{
+    try {
+        co_await q.push(value);
+        *err = 0;
+    } catch (const std::system_error &e) {
+        *err = e.code().value();
+    }
+}
+
+SCENARIO("満杯/空以外の失敗は待機せずに例外になること",
+         tags("queue_coro", "coro_queue_push")) {
+
+    GIVEN("満杯の後に EINVAL で失敗するチャネルを作成する") {
+        algorithms::awaitable_channel<failing_ops, int> ch(0);
+
+        WHEN("追加する") {
+            int err = -1;
+            push_catching(ch, 10, &err);
+
+            THEN("待機せずに例外を受け取ること") {
+                CHECK(err == EINVAL);
+            }
+        }
+    }
+}
+
+/**
+ *  Container driven by the test: pushes wait while @c full and fail with
+ *  EINVAL once @c pushes_left is used up, pops fail with EINVAL while
+ *  @c pops_fail.
+ */
+struct scripted {
+    int items;
+    bool full;
+    int pushes_left;
+    bool pops_fail;
+};
+
+struct scripted_ops {
+    using container_type = scripted;
+
+    static int create(scripted *c, size_t, size_t)
+    {
+        *c = scripted{0, false, 0, false};
+        return 0;
+    }
+
+    static int destroy(scripted *)
+    {
+        return 0;
+    }
+
+    static int try_push(scripted *c, const void *)
+    {
+        if (c->full) {
+            errno = EAGAIN;
+        } else if (c->pushes_left == 0) {
+            errno = EINVAL;
+        } else {
+            --c->pushes_left;
+            ++c->items;
+            return 0;
+        }
+        return algorithms::retry_on(-1, EAGAIN);
+    }
+
+    static int try_pop(scripted *c, void *value)
+    {
+        if (c->items == 0) {
+            errno = ENOENT;
+        } else if (c->pops_fail) {
+            errno = EINVAL;
+        } else {
+            --c->items;
+            *(int *)value = 42;
+            return 0;
+        }
+        return algorithms::retry_on(-1, ENOENT);
+    }
+};
+
+template <typename Q>
+static detached pop_catching(Q &q, int *out, int *err)
+{
+    try {
+        *out = co_await q.pop();
+        *err = 0;
+    } catch (const std::system_error &e) {
+        *err = e.code().value();
+    }
+}
+
+SCENARIO("待機中の操作の失敗は、再開を担ったスレッドには伝わらないこと",
+         tags("queue_coro", "coro_queue_push", "coro_queue_pop")) {
+
+    GIVEN("テストが失敗を指示するチャネルを作成する") {
+        algorithms::awaitable_channel<scripted_ops, int> ch(0);
+        scripted *c = ch.native();
+
+        WHEN("取得の待機中に、取得が EINVAL で失敗するようにして追加する") {
+            int out = -1, pop_err = -1, push_err = -1;
+            pop_catching(ch, &out, &pop_err);
+            CHECK(pop_err == -1);
+            c->pushes_left = 1;
+            c->pops_fail = true;
+            push_catching(ch, 10, &push_err);
+
+            THEN("追加は成功し、待機していた取得が例外を受け取ること") {
+                CHECK(push_err == 0);
+                CHECK(pop_err == EINVAL);
+            }
+        }
+
+        WHEN("取得と追加の待機中に、追加が EINVAL で失敗するようにして追加する") {
+            int out = -1, pop_err = -1, push_err[2] = {-1, -1};
+            c->full = true;
+            pop_catching(ch, &out, &pop_err);
+            push_catching(ch, 10, &push_err[0]);
+            CHECK(pop_err == -1);
+            CHECK(push_err[0] == -1);
+            c->full = false;
+            c->pushes_left = 1;
+            push_catching(ch, 11, &push_err[1]);
+
+            THEN("先に値を受け取った取得も再開され、失敗は待機していた追加にだけ伝わること") {
+                CHECK(push_err[1] == 0);
+                CHECK(pop_err == 0);
+                CHECK(out == 42);
+                CHECK(push_err[0] == EINVAL);
+            }
+        }
+    }
+}
+
+template <typename Q>
+static detached consume(Q &q, int count, std::atomic<long> *sum, std::atomic<int> *done)
+{
+    long s = 0;
+    for (int i = 0; i < count; ++i) {
+        s += co_await q.pop();
+    }
+    *sum = s;
+    ++*done;
+}
+
+template <typename Q>
+static detached produce(Q &q, int from, int count, std::atomic<int> *done)
+{
+    for (int i = from; i < from + count; ++i) {
+        co_await q.push(i);
+    }
+    ++*done;
+}
+
+SCENARIO("複数のスレッドから co_await で追加/取得できること",
+         tags("queue", "queue_coro", "coro_queue_push", "coro_queue_pop", "parallel")) {
+
+    static const int TEST_COUNT = 10000;
+
+    GIVEN("容量の小さいキューを作成する") {
+        coro_queue<int> q(16);
+
+        WHEN("取得を待機させ、２つのスレッドから追加する") {
+            std::atomic<long> sum{0};
+            std::atomic<int> done{0};
+            consume(q, TEST_COUNT * 2, &sum, &done);
+            std::vector<std::thread> producers;
+            for (int t = 0; t < 2; ++t) {
+                producers.emplace_back([&, t] {
+                    produce(q, t * TEST_COUNT, TEST_COUNT, &done);
+                });
+            }
+            for (auto &p: producers) {
+                p.join();
+            }
+
+            THEN("すべてのデータが 1 度ずつ取得できること") {
+                /* whatever is left suspended is resumed by the other side. */
+                CHECK(done == 3);
+                long n = TEST_COUNT * 2;
+                CHECK(sum == n * (n - 1) / 2);
+            }
+        }
+    }
+}
+
+static detached push_pop(coro_queue<int> &q, int ops, int *out)
+{
+    for (int i = 0; i < ops; ++i) {
+        co_await q.push(i);
+        *out = co_await q.pop();
+    }
+}
+
+SCENARIO("co_await による追加/取得のコストを計測する",
+         tags(".", "benchmark", "queue_coro", "coro_queue_push", "coro_queue_pop")) {
+
+    static const int OPS = 1000;
+
+    GIVEN("キューを作成する") {
+        queue_t raw;
+        coro_queue<int> q(0);
+
+        REQUIRE(queue_create(&raw, sizeof(int)) == 0);
+
+        BENCHMARK(std::to_string(OPS) + " x enqueue / dequeue") {
+            int buf;
+            for (int i = 0; i < OPS; ++i) {
+                queue_enqueue(&raw, &i);
+                queue_dequeue(&raw, &buf);
+            }
+            return buf;
+        };
+
+        /* one frame for all the operations: the awaiters allocate none. */
+        BENCHMARK(std::to_string(OPS) + " x co_await push / pop") {
+            int out;
+            push_pop(q, OPS, &out);
+            return out;
+        };
+
+        queue_destroy(&raw);
+    }
+}
@@ -8,8 +8,15 @@
  *  This code is licensed under the MIT License.
  */
 #include <sched.h>
+#include <poll.h>
 #include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
 #include <catch2/catch.hpp>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 #include "utils.hpp"
 
@@ -34,6 +41,26 @@ SCENARIO("キューを作成できること", tags("queue", "queue_create", "que
     }
 }
 
+SCENARIO("生産者側と消費者側が別のキャッシュラインに置かれること", tags("queue", "layout")) {
+
+    GIVEN("特になし") {
+
+        THEN("Head, Tail, size と設定値が別のラインにあること") {
+            CHECK(alignof(queue_t) >= CACHE_LINE_BYTES);
+            CHECK(offsetof(queue_t, Head) / CACHE_LINE_BYTES != offsetof(queue_t, Tail) / CACHE_LINE_BYTES);
+            CHECK(offsetof(queue_t, Tail) / CACHE_LINE_BYTES != offsetof(queue_t, size) / CACHE_LINE_BYTES);
+            CHECK(offsetof(queue_t, size) / CACHE_LINE_BYTES != offsetof(queue_t, value_bytes) / CACHE_LINE_BYTES);
+        }
+
+        THEN("メモリプールの head, tail, freeable と設定値が別のラインにあること") {
+            CHECK(alignof(mpool_t) >= CACHE_LINE_BYTES);
+            CHECK(offsetof(mpool_t, pool) / CACHE_LINE_BYTES != offsetof(mpool_t, head) / CACHE_LINE_BYTES);
+            CHECK(offsetof(mpool_t, head) / CACHE_LINE_BYTES != offsetof(mpool_t, tail) / CACHE_LINE_BYTES);
+            CHECK(offsetof(mpool_t, tail) / CACHE_LINE_BYTES != offsetof(mpool_t, freeable) / CACHE_LINE_BYTES);
+        }
+    }
+}
+
 SCENARIO("キューに最小数のデータを追加できること", tags("queue", "queue_enqueue", "minimum")) {
 
     GIVEN("キューを作成する") {
@@ -176,6 +203,559 @@ SCENARIO("キューへのデータの追加/取得が繰り返しできること
     }
 }
 
+SCENARIO("キューにまとめて追加/取得できること",
+         tags("queue", "queue_enqueue_n", "queue_dequeue_n")) {
+
+    GIVEN("キューを作成する") {
+        queue_t q;
+
+        REQUIRE(queue_create(&q, sizeof(int)) == 0);
+
+        WHEN("空のキューからまとめて取得する") {
+
+            THEN("取得に失敗すること") {
+                int buf[4];
+                CHECK(queue_dequeue_n(&q, buf, 4) == -1);
+                CHECK(errno == ENOENT);
+                CHECK(queue_dequeue_n(&q, buf, 0) == -1);
+                CHECK(errno == EINVAL);
+            }
+        }
+
+        WHEN("複数のデータをまとめて追加する") {
+            int data[]{10, 20, 30, 40, 50};
+            REQUIRE(queue_enqueue_n(&q, data, 5) == 0);
+
+            INFO("データ: " + array_to_string(data));
+
+            THEN("追加した順に 1 つずつ取得できること") {
+                int buf;
+                CHECK((queue_dequeue(&q, &buf)?:buf) == data[0]);
+                CHECK((queue_dequeue(&q, &buf)?:buf) == data[1]);
+                CHECK((queue_dequeue(&q, &buf)?:buf) == data[2]);
+                CHECK((queue_dequeue(&q, &buf)?:buf) == data[3]);
+                CHECK((queue_dequeue(&q, &buf)?:buf) == data[4]);
+                CHECK(queue_dequeue(&q, &buf) == -1);
+            }
+
+            THEN("追加した順にまとめて取得でき、残りが少なければその数だけ取得できること") {
+                int buf[4];
+                CHECK(queue_dequeue_n(&q, buf, 3) == 3);
+                CHECK(buf[0] == data[0]);
+                CHECK(buf[1] == data[1]);
+                CHECK(buf[2] == data[2]);
+                CHECK(queue_dequeue_n(&q, buf, 4) == 2);
+                CHECK(buf[0] == data[3]);
+                CHECK(buf[1] == data[4]);
+                CHECK(queue_dequeue_n(&q, buf, 4) == -1);
+                CHECK(errno == ENOENT);
+            }
+        }
+
+        WHEN("1 つずつとまとめての追加を混ぜる") {
+            int data = 10, batch[]{20, 30};
+            REQUIRE(queue_enqueue(&q, &data) == 0);
+            REQUIRE(queue_enqueue_n(&q, batch, 2) == 0);
+            REQUIRE((data = 40, queue_enqueue(&q, &data)) == 0);
+
+            THEN("追加した順にまとめて取得できること") {
+                int buf[8];
+                CHECK(queue_dequeue_n(&q, buf, 8) == 4);
+                CHECK(buf[0] == 10);
+                CHECK(buf[1] == 20);
+                CHECK(buf[2] == 30);
+                CHECK(buf[3] == 40);
+            }
+        }
+
+        queue_destroy(&q);
+    }
+
+    GIVEN("上限のあるキューを作成する") {
+        queue_t q;
+
+        REQUIRE(queue_create_pooled(&q, sizeof(int), 4, 4) == 0);
+
+        WHEN("上限を超える数をまとめて追加する") {
+            int data[]{10, 20, 30, 40};
+
+            THEN("1 つも追加されないこと") {
+                CHECK(queue_enqueue_n(&q, data, 4) == -1);
+                CHECK(errno == ENOMEM);
+                int buf;
+                CHECK(queue_dequeue(&q, &buf) == -1);
+                CHECK(queue_enqueue_n(&q, data, 3) == 0);
+            }
+        }
+
+        queue_destroy(&q);
+    }
+}
+
+SCENARIO("まとめての追加/取得を並列に行えること",
+         tags("queue", "queue_enqueue_n", "queue_dequeue_n", "parallel")) {
+
+    for (unsigned int flags: {0U, QUEUE_FLAG_EPOCH}) {
+
+        GIVEN(std::string((flags & QUEUE_FLAG_EPOCH) ? "epoch" : "hazard") + " で回収するキューを作成する") {
+            queue_t q;
+
+            REQUIRE(queue_create_flags(&q, sizeof(int), flags) == 0);
+
+            WHEN("２つのスレッドからまとめて追加し、２つのスレッドからまとめて取得する") {
+                static const int TEST_COUNT = 10000;
+                static const int BATCH = 7;
+                BITFLAG bf = bitflag_create(TEST_COUNT * 2);
+                std::atomic<int> taken(0);
+
+                std::vector<std::thread> workers;
+                for (int t = 0; t < 2; ++t) {
+                    workers.emplace_back([&q, t] {
+                        int batch[BATCH];
+                        for (int i = 0; i < TEST_COUNT; i += BATCH) {
+                            int n = std::min(BATCH, TEST_COUNT - i);
+                            for (int k = 0; k < n; ++k) {
+                                batch[k] = (TEST_COUNT * t) + i + k;
+                            }
+                            queue_enqueue_n(&q, batch, n);
+                        }
+                    });
+                    workers.emplace_back([&q, &bf, &taken] {
+                        int buf[BATCH];
+                        while (taken.load() < TEST_COUNT * 2) {
+                            ssize_t n = queue_dequeue_n(&q, buf, BATCH);
+                            if (n <= 0) {
+                                sched_yield();
+                                continue;
+                            }
+                            for (ssize_t k = 0; k < n; ++k) {
+                                bitflag_set(bf, buf[k]);
+                            }
+                            taken += n;
+                        }
+                    });
+                }
+                for (auto &w: workers) {
+                    w.join();
+                }
+
+                THEN("すべてのデータが 1 度ずつ取得できること") {
+                    CHECK(taken.load() == TEST_COUNT * 2);
+                    bool is_all_set = true;
+                    for (int i = 0; i < (TEST_COUNT * 2); ++i) {
+                        if (!bitflag_check(bf, i)) {
+                            is_all_set = false;
+                        }
+                    }
+                    CHECK(is_all_set == true);
+                }
+
+                bitflag_destroy(bf);
+            }
+
+            queue_destroy(&q);
+        }
+    }
+}
+
+SCENARIO("キューのノードがプールから割り当てられること",
+         tags("queue", "queue_create_pooled", "queue_enqueue", "queue_dequeue")) {
+
+    GIVEN("プールを小さく指定してキューを作成する") {
+        queue_t q;
+        size_t prealloc{4}, limit{28};
+
+        INFO("初期数: " + std::to_string(prealloc) + ", 上限: " + std::to_string(limit));
+
+        REQUIRE(queue_create_pooled(&q, sizeof(int), prealloc, limit) == 0);
+        REQUIRE(q.npools == 1);
+
+        WHEN("追加/取得を繰り返す") {
+
+            THEN("プールが増えないこと") {
+                for (int i = 0; i < 1000; ++i) {
+                    int buf;
+                    REQUIRE(queue_enqueue(&q, &i) == 0);
+                    REQUIRE((queue_dequeue(&q, &buf)?:buf) == i);
+                }
+                CHECK(q.npools == 1);
+            }
+        }
+
+        WHEN("上限まで追加する") {
+
+            THEN("プールが倍々に増え、上限で追加できなくなること") {
+                /* one node is the dummy. */
+                for (int i = 0; i < (int)limit - 1; ++i) {
+                    REQUIRE(queue_enqueue(&q, &i) == 0);
+                }
+                CHECK(q.npools == 3);
+                int data = -1;
+                CHECK(queue_enqueue(&q, &data) == -1);
+                CHECK(errno == ENOMEM);
+
+                for (int i = 0; i < (int)limit - 1; ++i) {
+                    int buf;
+                    REQUIRE((queue_dequeue(&q, &buf)?:buf) == i);
+                }
+                CHECK(queue_enqueue(&q, &data) == 0);
+            }
+        }
+
+        queue_destroy(&q);
+    }
+
+    GIVEN("特になし") {
+
+        WHEN("初期数 0 でキューを作成する") {
+            queue_t q;
+
+            THEN("作成に失敗すること") {
+                CHECK(queue_create_pooled(&q, sizeof(int), 0, 0) == -1);
+                CHECK(errno == EINVAL);
+            }
+        }
+    }
+}
+
+SCENARIO("取得済みのノードが安全に回収されること",
+         tags("queue", "queue_create_flags", "queue_enqueue", "queue_dequeue", "smr")) {
+
+    for (unsigned int flags: {0U, QUEUE_FLAG_EPOCH}) {
+        std::string name = (flags & QUEUE_FLAG_EPOCH) ? "epoch" : "hazard pointer";
+
+        GIVEN(name + " で回収するキューを作成する") {
+            queue_t q;
+
+            REQUIRE(queue_create_flags(&q, sizeof(int), flags) == 0);
+
+            WHEN("追加/取得を繰り返す") {
+
+                THEN("回収されたノードが再利用されること") {
+                    for (int i = 0; i < 10000; ++i) {
+                        int buf;
+                        REQUIRE(queue_enqueue(&q, &i) == 0);
+                        REQUIRE((queue_dequeue(&q, &buf)?:buf) == i);
+                    }
+                    CHECK(q.npools == 1);
+                }
+            }
+
+            WHEN("２つのスレッドから同時に追加/取得する") {
+                static const int TEST_COUNT = 10000;
+
+                BITFLAG bf = bitflag_create(TEST_COUNT * 2);
+                auto worker = [&](void *arg) -> void * {
+                    int offset = (int)(intptr_t)arg;
+                    for (int i = 0; i < TEST_COUNT; ++i) {
+                        int data = offset + i, buf = -1;
+                        if ((queue_enqueue(&q, &data) != 0) || (queue_dequeue(&q, &buf) != 0)) {
+                            return (void *)(intptr_t)i;
+                        }
+                        bitflag_set(bf, buf);
+                    }
+                    return (void *)(intptr_t)TEST_COUNT;
+                };
+
+                pthread_t thr[2];
+                for (int i = 0; i < 2; ++i) {
+                    REQUIRE(pthread_create(&thr[i], NULL, Lambda::ptr<void *, void *>(worker),
+                                           (void *)(intptr_t)(TEST_COUNT * i)) == 0);
+                }
+
+                THEN("データが追加/取得できること") {
+                    intptr_t count = 0;
+                    for (int i = 0; i < 2; ++i) {
+                        REQUIRE((pthread_join(thr[i], (void **)&count)?:count) == TEST_COUNT);
+                    }
+                    bool is_all_set = true;
+                    for (int i = 0; i < (TEST_COUNT * 2); ++i) {
+                        if (!bitflag_check(bf, i)) {
+                            is_all_set = false;
+                        }
+                    }
+                    CHECK(is_all_set == true);
+                }
+
+                bitflag_destroy(bf);
+            }
+
+            queue_destroy(&q);
+        }
+    }
+}
+
+SCENARIO("空のキューからの取得を待機できること", tags("queue", "queue_dequeue_wait")) {
+
+    GIVEN("キューを作成する") {
+        queue_t q;
+
+        REQUIRE(queue_create(&q, sizeof(int)) == 0);
+
+        WHEN("空のまま待機する") {
+
+            THEN("タイムアウトすること") {
+                int buf;
+                CHECK(queue_dequeue_wait(&q, &buf, 20) == -1);
+                CHECK(errno == ETIMEDOUT);
+            }
+        }
+
+        WHEN("別のスレッドから遅れてデータを追加する") {
+            auto pusher = [&](void *) -> void * {
+                int data = 10;
+                msleep(20);
+                return (void *)(intptr_t)queue_enqueue(&q, &data);
+            };
+            pthread_t thr;
+            REQUIRE(pthread_create(&thr, NULL, Lambda::ptr<void *, void *>(pusher), NULL) == 0);
+
+            THEN("追加されたデータが取得できること") {
+                int buf = -1;
+                CHECK((queue_dequeue_wait(&q, &buf, -1)?:buf) == 10);
+                REQUIRE(pthread_join(thr, NULL) == 0);
+            }
+        }
+
+        queue_destroy(&q);
+    }
+}
+
+SCENARIO("容量を指定したキューが上限を超えて追加しないこと",
+         tags("queue", "queue_create_bounded", "queue_try_enqueue", "queue_enqueue")) {
+
+    static const size_t CAPACITY = 4;
+
+    GIVEN("特になし") {
+
+        WHEN("容量 0 でキューを作成する") {
+            queue_t q;
+
+            THEN("作成に失敗すること") {
+                CHECK(queue_create_bounded(&q, sizeof(int), 0) == -1);
+                CHECK(errno == EINVAL);
+            }
+        }
+    }
+
+    GIVEN("容量を指定してキューを作成する") {
+        queue_t q;
+
+        REQUIRE(queue_create_bounded(&q, sizeof(int), CAPACITY) == 0);
+
+        WHEN("容量まで追加する") {
+            for (int i = 0; i < (int)CAPACITY; ++i) {
+                REQUIRE(queue_try_enqueue(&q, &i) == 0);
+            }
+
+            THEN("それ以上は EAGAIN で追加できず、取得すれば追加できること") {
+                int data = 10, buf;
+                CHECK(queue_try_enqueue(&q, &data) == -1);
+                CHECK(errno == EAGAIN);
+                CHECK((queue_dequeue(&q, &buf)?:buf) == 0);
+                CHECK(queue_try_enqueue(&q, &data) == 0);
+                CHECK(queue_try_enqueue(&q, &data) == -1);
+            }
+
+            THEN("容量を超える数をまとめて追加できないこと") {
+                int data[CAPACITY + 1]{};
+                CHECK(queue_enqueue_n(&q, data, CAPACITY + 1) == -1);
+                CHECK(errno == EINVAL);
+            }
+        }
+
+        WHEN("満杯のキューに追加し、別のスレッドから遅れて取得する") {
+            for (int i = 0; i < (int)CAPACITY; ++i) {
+                REQUIRE(queue_enqueue(&q, &i) == 0);
+            }
+            auto popper = [&](void *) -> void * {
+                int buf[2];
+                msleep(20);
+                return (void *)(intptr_t)queue_dequeue_n(&q, buf, 2);
+            };
+            pthread_t thr;
+            REQUIRE(pthread_create(&thr, NULL, Lambda::ptr<void *, void *>(popper), NULL) == 0);
+
+            THEN("空きができるまで待って追加できること") {
+                int data[2] = {10, 11};
+                CHECK(queue_enqueue(&q, &data[0]) == 0);
+                CHECK(queue_enqueue_n(&q, data, 1) == 0);
+                void *ret;
+                REQUIRE(pthread_join(thr, &ret) == 0);
+                CHECK((intptr_t)ret == 2);
+
+                int buf[CAPACITY];
+                CHECK(queue_dequeue_n(&q, buf, CAPACITY) == (ssize_t)CAPACITY);
+                CHECK(buf[0] == 2);
+                CHECK(buf[1] == 3);
+                CHECK(buf[2] == 10);
+                CHECK(buf[3] == 10);
+            }
+        }
+
+        queue_destroy(&q);
+    }
+}
+
+SCENARIO("サイズが水位を越えるたびに通知されること",
+         tags("queue", "queue_set_watermarks", "queue_enqueue", "queue_dequeue")) {
+
+    struct marks {
+        std::vector<int> seen;
+    };
+    auto record = [](queue_t *, int mark, void *arg) {
+        static_cast<marks *>(arg)->seen.push_back(mark);
+    };
+
+    GIVEN("容量を指定してキューを作成する") {
+        queue_t q;
+        marks m;
+
+        REQUIRE(queue_create_bounded(&q, sizeof(int), 8) == 0);
+
+        WHEN("不正な水位を設定する") {
+
+            THEN("設定に失敗すること") {
+                CHECK(queue_set_watermarks(&q, 4, 4, record, &m) == -1);
+                CHECK(errno == EINVAL);
+                CHECK(queue_set_watermarks(&q, 9, 2, record, &m) == -1);
+                CHECK(errno == EINVAL);
+            }
+        }
+
+        WHEN("高水位 6、低水位 2 を設定して追加/取得する") {
+            REQUIRE(queue_set_watermarks(&q, 6, 2, record, &m) == 0);
+
+            THEN("越えたときに 1 度ずつ、高低交互に通知されること") {
+                int data = 10, buf;
+                for (int i = 0; i < 5; ++i) {
+                    REQUIRE(queue_enqueue(&q, &data) == 0);
+                }
+                CHECK(m.seen.empty());
+                REQUIRE(queue_enqueue(&q, &data) == 0);
+                REQUIRE(queue_enqueue(&q, &data) == 0);
+                CHECK(m.seen == std::vector<int>{QUEUE_WATERMARK_HIGH});
+
+                /* between the marks: no calls either way. */
+                for (int i = 0; i < 3; ++i) {
+                    REQUIRE(queue_dequeue(&q, &buf) == 0);
+                }
+                REQUIRE(queue_enqueue(&q, &data) == 0);
+                CHECK(m.seen.size() == 1);
+
+                for (int i = 0; i < 3; ++i) {
+                    REQUIRE(queue_dequeue(&q, &buf) == 0);
+                }
+                CHECK(m.seen == std::vector<int>{QUEUE_WATERMARK_HIGH, QUEUE_WATERMARK_LOW});
+                REQUIRE(queue_dequeue(&q, &buf) == 0);
+                CHECK(m.seen.size() == 2);
+            }
+        }
+
+        queue_destroy(&q);
+    }
+}
+
+static bool readable(int fd)
+{
+    struct pollfd pfd = {fd, POLLIN, 0};
+    return (poll(&pfd, 1, 0) == 1) && (pfd.revents & POLLIN);
+}
+
+SCENARIO("空でなくなったことを eventfd で通知できること",
+         tags("queue", "queue_eventfd", "queue_eventfd_ack", "queue_enqueue")) {
+
+    GIVEN("通知なしでキューを作成する") {
+        queue_t q;
+
+        REQUIRE(queue_create(&q, sizeof(int)) == 0);
+
+        WHEN("eventfd を取得する") {
+
+            THEN("取得に失敗すること") {
+                CHECK(queue_eventfd(&q) == -1);
+                CHECK(errno == EINVAL);
+            }
+        }
+
+        queue_destroy(&q);
+    }
+
+    GIVEN("eventfd 通知でキューを作成する") {
+        queue_t q;
+
+        REQUIRE(queue_create_flags(&q, sizeof(int), QUEUE_FLAG_EVENTFD) == 0);
+        int fd = queue_eventfd(&q);
+        REQUIRE(fd >= 0);
+
+        WHEN("何度か追加する") {
+            CHECK_FALSE(readable(fd));
+            for (int i = 0; i < 3; ++i) {
+                REQUIRE(queue_enqueue(&q, &i) == 0);
+            }
+
+            THEN("書き込みは 1 度だけで、応答するまで再通知されないこと") {
+                uint64_t count = 0;
+                CHECK(read(fd, &count, sizeof(count)) == sizeof(count));
+                CHECK(count == 1);
+                int data = 10;
+                REQUIRE(queue_enqueue(&q, &data) == 0);
+                CHECK_FALSE(readable(fd));
+            }
+
+            THEN("応答して取り尽くすと、次の追加で再通知されること") {
+                CHECK(readable(fd));
+                CHECK(queue_eventfd_ack(&q) == 0);
+                int buf[4];
+                CHECK(queue_dequeue_n(&q, buf, 4) == 3);
+                CHECK_FALSE(readable(fd));
+                int data = 10;
+                REQUIRE(queue_enqueue_n(&q, &data, 1) == 0);
+                CHECK(readable(fd));
+            }
+        }
+
+        WHEN("別のスレッドで epoll を待ちながら取得する") {
+            static const int TEST_COUNT = 10000;
+            auto consumer = [&](void *) -> void * {
+                int ep = epoll_create1(0);
+                struct epoll_event ev{};
+                ev.events = EPOLLIN;
+                if (epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                    return (void *)(intptr_t)-1;
+                }
+                intptr_t count = 0;
+                while (count < TEST_COUNT) {
+                    if (epoll_wait(ep, &ev, 1, 1000) != 1) {
+                        break;
+                    }
+                    queue_eventfd_ack(&q);
+                    int buf[64];
+                    ssize_t n;
+                    while ((n = queue_dequeue_n(&q, buf, 64)) > 0) {
+                        count += n;
+                    }
+                }
+                close(ep);
+                return (void *)count;
+            };
+            pthread_t thr;
+            REQUIRE(pthread_create(&thr, NULL, Lambda::ptr<void *, void *>(consumer), NULL) == 0);
+            for (int i = 0; i < TEST_COUNT; ++i) {
+                REQUIRE(queue_enqueue(&q, &i) == 0);
+            }
+
+            THEN("すべてのデータが取得できること") {
+                intptr_t count;
+                REQUIRE(pthread_join(thr, (void **)&count) == 0);
+                CHECK(count == TEST_COUNT);
+            }
+        }
+
+        queue_destroy(&q);
+    }
+}
+
 SCENARIO("キューへの並列アクセスが可能であること",
          tags("queue", "queue_enqueue", "queue_dequeue", "parallel")) {
 
@@ -210,7 +790,7 @@ SCENARIO("キューへの並列アクセスが可能であること",
             pthread_t pusher_thr1, pusher_thr2;
             struct param param_thr1 = {.count = TEST_COUNT, .offset = 0, .callback = pusher},
                          param_thr2 = {.count = TEST_COUNT, .offset = TEST_COUNT, .callback = pusher};
-            int count = 0;
+            intptr_t count = 0;
             REQUIRE(pthread_create(&pusher_thr1, NULL, Lambda::ptr<void *, void *>(worker), &param_thr1) == 0);
             REQUIRE(pthread_create(&pusher_thr2, NULL, Lambda::ptr<void *, void *>(worker), &param_thr2) == 0);
             REQUIRE((pthread_join(pusher_thr1, (void **)&count)?:count) == TEST_COUNT);
@@ -254,7 +834,7 @@ SCENARIO("キューへの並列アクセスが可能であること",
             pthread_t pusher_thr1, pusher_thr2;
             struct param param_thr1 = {.count = TEST_COUNT, .offset = 0, .callback = pusher},
                          param_thr2 = {.count = TEST_COUNT, .offset = TEST_COUNT, .callback = pusher};
-            int count = 0;
+            intptr_t count = 0;
             REQUIRE(pthread_create(&pusher_thr1, NULL, Lambda::ptr<void *, void *>(worker), &param_thr1) == 0);
             REQUIRE(pthread_create(&pusher_thr2, NULL, Lambda::ptr<void *, void *>(worker), &param_thr2) == 0);
             msleep(10);
@@ -0,0 +1,309 @@
+/** @file       faa_queue.c
+ *  @brief      Fetch-and-add array queue implementation.
+ *
+ *  An unbounded MPMC queue built from a linked list of array segments.
+ *  Instead of racing for the tail with CAS, as the Michael-Scott queue
+ *  does, every operation takes a ticket with fetch-and-add on the
+ *  segment's enqueue (dequeue) index and owns the cell it names; the
+ *  only contended instruction is then the fetch-and-add, which always
+ *  succeeds, so there is no retry storm however many threads pile on.
+ *
+ *  An enqueuer fills its cell and publishes it with a CAS from empty to
+ *  full. A dequeuer that arrives first swaps the cell to taken, so the
+ *  late enqueuer's CAS fails and it takes another ticket. When the
+ *  tickets run past the end of a segment, a new segment holding the
+ *  value is appended and the tail swung to it, as in the Michael-Scott
+ *  queue; drained segments are unlinked from the head and reclaimed with
+ *  hazard pointers.
+ *
+ *  LCRQ reaches the same fetch-and-add fast path with rings of 16-byte
+ *  cells swapped by CAS2, which needs the value to fit a word; cells
+ *  that are written once keep values of any size inline.
+ *
+ *  @sa         [P.Ramalhete&A.Correia,FAAArrayQueue,Concurrency Freaks 2016]
+ *  @sa         [A.Morrison&Y.Afek,Fast Concurrent Queues for x86
+ *              Processors,PPoPP 2013]
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+
+#include "aux.h"
+#include "debug.h"
+#include "atomic.h"
+#include "faa_queue.h"
+
+#define FAA_CACHE_LINE CACHE_LINE_BYTES
+
+enum {
+    CELL_EMPTY = 0,
+    CELL_FULL,
+    CELL_TAKEN,             /* a dequeuer gave up waiting for the enqueuer. */
+};
+
+struct faa_cell {
+    size_t state;
+    alignas(8) uint8_t value[];
+};
+
+struct faa_segment {
+    alignas(FAA_CACHE_LINE) size_t enqidx;
+    alignas(FAA_CACHE_LINE) size_t deqidx;
+    alignas(FAA_CACHE_LINE) struct faa_segment *next;
+    alignas(FAA_CACHE_LINE) uint8_t cells[];
+};
+
+static inline size_t cell_byte_aligned(size_t value_bytes)
+{
+    size_t cell_bytes = sizeof(struct faa_cell) + value_bytes;
+    if (cell_bytes % sizeof(size_t)) {
+        cell_bytes += sizeof(size_t) - (cell_bytes % sizeof(size_t));
+    }
+    return cell_bytes;
+}
+
+static inline struct faa_cell *cell_of(faa_queue_t *self, struct faa_segment *seg, size_t idx)
+{
+    return (struct faa_cell *)((uintptr_t)seg->cells + (self->cell_bytes * idx));
+}
+
+/**
+ *  Allocates an empty segment, or one whose first cell already holds
+ *  @c value.
+ */
+static struct faa_segment *new_segment(faa_queue_t *self, const void *value)
+{
+    size_t bytes = sizeof(struct faa_segment) + (self->cell_bytes * FAA_SEGMENT_CELLS);
+    if (bytes % FAA_CACHE_LINE) {
+        bytes += FAA_CACHE_LINE - (bytes % FAA_CACHE_LINE);
+    }
+    struct faa_segment *seg = aligned_alloc(FAA_CACHE_LINE, bytes);
+    if (seg == NULL) {
+        return NULL;
+    }
+    memset(seg, 0, bytes);
+    if (value != NULL) {
+        struct faa_cell *cell = cell_of(self, seg, 0);
+        memcpy(cell->value, value, self->value_bytes);
+        cell->state = CELL_FULL;
+        seg->enqidx = 1;
+    }
+    return seg;
+}
+
+static void free_segment(void *ptr, void *arg)
+{
+    UNUSED_VARIABLE(arg);
+
+    free(ptr);
+}
+
+/**
+ *  Reads @c *src and publishes the segment it names until @c *src is seen
+ *  unchanged.
+ */
+static inline struct faa_segment *load_protected(faa_queue_t *self, struct smr_record *r,
+                                                 struct faa_segment **src)
+{
+    struct faa_segment *seg = atomic_load(src);
+    while (true) {
+        smr_protect(&self->smr, r, 0, seg);
+        struct faa_segment *again = atomic_load(src);
+        if (again == seg) {
+            return seg;
+        }
+        seg = again;
+    }
+}
+
+int faa_queue_create(faa_queue_t *q, size_t value_bytes)
+{
+    if ((q == NULL) || (value_bytes == 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    q->value_bytes = value_bytes;
+    q->cell_bytes = cell_byte_aligned(value_bytes);
+    if (q->cell_bytes > (SIZE_MAX - sizeof(struct faa_segment)) / FAA_SEGMENT_CELLS / 2) {
+        errno = EINVAL;
+        return -1;
+    }
+    smr_init(&q->smr, SMR_HAZARD, free_segment, q);
+    struct faa_segment *seg = new_segment(q, NULL);
+    if (seg == NULL) {
+        return -1;
+    }
+    atomic_store(&q->head, seg);
+    atomic_store(&q->tail, seg);
+
+    return 0;
+}
+
+int faa_queue_destroy(faa_queue_t *q)
+{
+    if (q == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* retired segments are already unlinked, so each is freed once. */
+    smr_destroy(&q->smr);
+    struct faa_segment *seg = q->head;
+    while (seg != NULL) {
+        struct faa_segment *next = seg->next;
+        free(seg);
+        seg = next;
+    }
+    q->head = q->tail = NULL;
+
+    return 0;
+}
+
+int faa_queue_enqueue(faa_queue_t *q, const void *value)
+{
+    if ((q == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct smr_record *r = smr_enter(&q->smr);
+    if (r == NULL) {
+        return -1;
+    }
+    while (true) {
+        struct faa_segment *tail = load_protected(q, r, &q->tail);
+        size_t idx = atomic_fetch_add_explicit(&tail->enqidx, 1, memory_order_relaxed);
+        if (idx < FAA_SEGMENT_CELLS) {
+            struct faa_cell *cell = cell_of(q, tail, idx);
+            size_t empty = CELL_EMPTY;
+            if (atomic_load_explicit(&cell->state, memory_order_relaxed) != CELL_EMPTY) {
+                continue;
+            }
+            memcpy(cell->value, value, q->value_bytes);
+            if (atomic_compare_exchange_strong_explicit(&cell->state, &empty, CELL_FULL,
+                                                        memory_order_release,
+                                                        memory_order_relaxed)) {
+                break;
+            }
+            continue;
+        }
+
+        /* the segment is full: append a new one, or help the tail onto it. */
+        if (tail != atomic_load(&q->tail)) {
+            continue;
+        }
+        struct faa_segment *next = atomic_load(&tail->next);
+        if (next == NULL) {
+            struct faa_segment *seg = new_segment(q, value);
+            if (seg == NULL) {
+                smr_leave(&q->smr, r);
+                errno = ENOMEM;
+                return -1;
+            }
+            if (atomic_compare_exchange_strong(&tail->next, &next, seg)) {
+                atomic_compare_exchange_strong(&q->tail, &tail, seg);
+                break;
+            }
+            free(seg);
+        } else {
+            atomic_compare_exchange_strong(&q->tail, &tail, next);
+        }
+    }
+    smr_leave(&q->smr, r);
+
+    return 0;
+}
+
+int faa_queue_dequeue(faa_queue_t *q, void *value)
+{
+    if ((q == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct smr_record *r = smr_enter(&q->smr);
+    if (r == NULL) {
+        return -1;
+    }
+    while (true) {
+        struct faa_segment *head = load_protected(q, r, &q->head);
+        /* don't burn a ticket, and the enqueuer's cell with it, when empty. */
+        if ((atomic_load(&head->deqidx) >= atomic_load(&head->enqidx))
+            && (atomic_load(&head->next) == NULL)) {
+            break;
+        }
+        size_t idx = atomic_fetch_add_explicit(&head->deqidx, 1, memory_order_relaxed);
+        if (idx < FAA_SEGMENT_CELLS) {
+            struct faa_cell *cell = cell_of(q, head, idx);
+            if (atomic_exchange_explicit(&cell->state, CELL_TAKEN,
+                                         memory_order_acquire) == CELL_FULL) {
+                memcpy(value, cell->value, q->value_bytes);
+                smr_leave(&q->smr, r);
+                return 0;
+            }
+            continue;
+        }
+
+        /* the segment is drained: unlink it if there is a next one. */
+        struct faa_segment *next = atomic_load(&head->next);
+        if (next == NULL) {
+            break;
+        }
+        /* the tail must not lag on a segment about to be retired. */
+        struct faa_segment *expected = head;
+        atomic_compare_exchange_strong(&q->tail, &expected, next);
+        expected = head;
+        if (atomic_compare_exchange_strong(&q->head, &expected, next)) {
+            smr_retire(&q->smr, r, head);
+        }
+    }
+    smr_leave(&q->smr, r);
+
+    errno = ENOENT;
+    return -1;
+}
+
+void *faa_queue_to_array(faa_queue_t *q)
+{
+    if (q == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    size_t n = 0;
+    for (struct faa_segment *seg = atomic_load(&q->head); seg != NULL; seg = seg->next) {
+        for (size_t i = 0; i < FAA_SEGMENT_CELLS; ++i) {
+            n += (cell_of(q, seg, i)->state == CELL_FULL) ? 1 : 0;
+        }
+    }
+    size_t size = q->value_bytes;
+    uint8_t *ptr = calloc(n, size);
+    if (ptr == NULL) {
+        return NULL;
+    }
+    size_t k = 0;
+    for (struct faa_segment *seg = atomic_load(&q->head); seg != NULL; seg = seg->next) {
+        for (size_t i = 0; i < FAA_SEGMENT_CELLS; ++i) {
+            struct faa_cell *cell = cell_of(q, seg, i);
+            if (cell->state == CELL_FULL) {
+                memcpy(&ptr[size * k++], cell->value, size);
+            }
+        }
+    }
+
+    return ptr;
+}
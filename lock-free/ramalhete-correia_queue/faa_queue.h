@@ -0,0 +1,51 @@
+/** @file       faa_queue.h
+ *  @brief      Fetch-and-add array queue implementation.
+ *
+ *  @sa         [P.Ramalhete&A.Correia,FAAArrayQueue,Concurrency Freaks 2016]
+ *  @sa         [A.Morrison&Y.Afek,Fast Concurrent Queues for x86
+ *              Processors,PPoPP 2013]
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __ALGORITHMS_INTERNAL_FAA_QUEUE_H__
+#define __ALGORITHMS_INTERNAL_FAA_QUEUE_H__
+
+#include <stdalign.h>
+#include <stddef.h>
+
+#include "smr.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct faa_segment;
+
+/* cells per segment. */
+#define FAA_SEGMENT_CELLS 1024
+
+typedef struct faa_queue {
+    alignas(CACHE_LINE_BYTES) struct faa_segment *head;
+    alignas(CACHE_LINE_BYTES) struct faa_segment *tail;
+    alignas(CACHE_LINE_BYTES) size_t value_bytes;
+    size_t cell_bytes;
+    struct smr_domain smr;      /* drained segments wait here until unreachable. */
+} faa_queue_t;
+
+int faa_queue_create(faa_queue_t *q, size_t value_bytes);
+int faa_queue_destroy(faa_queue_t *q);
+/* fails with ENOMEM only when a new segment cannot be allocated. */
+int faa_queue_enqueue(faa_queue_t *q, const void *value);
+/* fails with ENOENT while empty. */
+int faa_queue_dequeue(faa_queue_t *q, void *value);
+void *faa_queue_to_array(faa_queue_t *q);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __ALGORITHMS_INTERNAL_FAA_QUEUE_H__ */
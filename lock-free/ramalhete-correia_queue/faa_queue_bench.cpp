@@ -0,0 +1,97 @@
+/** @file       faa_queue_bench.cpp
+ *  @brief      Benchmark for Fetch-and-add array queue.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "faa_queue.h"
+#include "queue.h"
+
+SCENARIO("キューの操作コストを計測する", tags(".", "benchmark", "faa_queue_enqueue", "faa_queue_dequeue")) {
+
+    GIVEN("キューを作成する") {
+        faa_queue_t f;
+        queue_t q;
+
+        REQUIRE(faa_queue_create(&f, sizeof(int)) == 0);
+        REQUIRE(queue_create(&q, sizeof(int)) == 0);
+
+        BENCHMARK("faa enqueue / dequeue") {
+            int data = 10, buf;
+            faa_queue_enqueue(&f, &data);
+            return faa_queue_dequeue(&f, &buf);
+        };
+
+        BENCHMARK("michael-scott enqueue / dequeue") {
+            int data = 10, buf;
+            queue_enqueue(&q, &data);
+            return queue_dequeue(&q, &buf);
+        };
+
+        queue_destroy(&q);
+        faa_queue_destroy(&f);
+    }
+}
+
+/**
+ *  Runs @c threads threads, each doing @c ops balanced enqueue/dequeue pairs.
+ */
+static void run_balanced(int threads, int ops,
+                         std::function<int(int *)> enqueue,
+                         std::function<int(int *)> dequeue)
+{
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([=] {
+            int data = t, buf;
+            for (int i = 0; i < ops; ++i) {
+                enqueue(&data);
+                dequeue(&buf);
+            }
+        });
+    }
+    for (auto &w: workers) {
+        w.join();
+    }
+}
+
+SCENARIO("FAA キューと Michael-Scott キューをスレッド数ごとに比較する",
+         tags(".", "benchmark", "faa_queue_create", "parallel")) {
+
+    static const int OPS = 10000;
+
+    GIVEN("キューを作成する") {
+        faa_queue_t f;
+        queue_t q;
+
+        REQUIRE(faa_queue_create(&f, sizeof(int)) == 0);
+        REQUIRE(queue_create(&q, sizeof(int)) == 0);
+
+        for (int threads: {1, 4, 16, 64, 128, 256}) {
+            BENCHMARK("faa " + std::to_string(threads) + " threads") {
+                run_balanced(threads, OPS,
+                             [&](int *v) { return faa_queue_enqueue(&f, v); },
+                             [&](int *v) { return faa_queue_dequeue(&f, v); });
+            };
+            BENCHMARK("michael-scott " + std::to_string(threads) + " threads") {
+                run_balanced(threads, OPS,
+                             [&](int *v) { return queue_enqueue(&q, v); },
+                             [&](int *v) { return queue_dequeue(&q, v); });
+            };
+        }
+
+        queue_destroy(&q);
+        faa_queue_destroy(&f);
+    }
+}
@@ -0,0 +1,277 @@
+/** @file       faa_queue_test.cpp
+ *  @brief      Unit-test for Fetch-and-add array queue.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <sched.h>
+#include <pthread.h>
+#include <catch2/catch.hpp>
+
+#include "utils.hpp"
+
+#include "faa_queue.h"
+
+extern "C" {
+#include "debug.h"
+}
+
+SCENARIO("キューを作成できること", tags("faa_queue", "faa_queue_create", "faa_queue_destroy")) {
+
+    GIVEN("特になし") {
+
+        WHEN("キューを作成する") {
+            faa_queue_t q;
+
+            THEN("キューが作成できること") {
+                REQUIRE(faa_queue_create(&q, sizeof(int)) == 0);
+                faa_queue_destroy(&q);
+            }
+        }
+
+        WHEN("値のサイズ 0 でキューを作成する") {
+            faa_queue_t q;
+
+            THEN("作成に失敗すること") {
+                CHECK(faa_queue_create(&q, 0) == -1);
+                CHECK(errno == EINVAL);
+            }
+        }
+    }
+}
+
+SCENARIO("キューにデータを追加できること", tags("faa_queue", "faa_queue_enqueue")) {
+
+    GIVEN("キューを作成する") {
+        faa_queue_t q;
+
+        REQUIRE(faa_queue_create(&q, sizeof(int)) == 0);
+
+        WHEN("キューに複数のデータを追加する") {
+            int data[]{10, 20, 30, 40};
+
+            INFO("データ: " + array_to_string(data));
+
+            THEN("データが追加できること") {
+                CHECK(faa_queue_enqueue(&q, &data[0]) == 0);
+                CHECK(faa_queue_enqueue(&q, &data[1]) == 0);
+                CHECK(faa_queue_enqueue(&q, &data[2]) == 0);
+                CHECK(faa_queue_enqueue(&q, &data[3]) == 0);
+
+                int *buf = (int *)faa_queue_to_array(&q);
+                CHECK(buf != NULL);
+                if (buf != NULL) {
+                    CHECK(buf[0] == data[0]);
+                    CHECK(buf[1] == data[1]);
+                    CHECK(buf[2] == data[2]);
+                    CHECK(buf[3] == data[3]);
+                    free(buf);
+                }
+            }
+        }
+
+        faa_queue_destroy(&q);
+    }
+}
+
+SCENARIO("キューからデータを取得できること", tags("faa_queue", "faa_queue_dequeue")) {
+
+    GIVEN("キューを作成する") {
+        faa_queue_t q;
+
+        REQUIRE(faa_queue_create(&q, sizeof(int)) == 0);
+
+        WHEN("空のキューから取得する") {
+
+            THEN("取得に失敗すること") {
+                int buf;
+                CHECK(faa_queue_dequeue(&q, &buf) == -1);
+                CHECK(errno == ENOENT);
+            }
+        }
+
+        WHEN("キューに複数のデータを追加する") {
+            int data[]{10, 20, 30, 40};
+            for (auto d: data) {
+                REQUIRE(faa_queue_enqueue(&q, &d) == 0);
+            }
+
+            THEN("追加した順にデータが取得できること") {
+                int buf;
+                CHECK((faa_queue_dequeue(&q, &buf)?:buf) == data[0]);
+                CHECK((faa_queue_dequeue(&q, &buf)?:buf) == data[1]);
+                CHECK((faa_queue_dequeue(&q, &buf)?:buf) == data[2]);
+                CHECK((faa_queue_dequeue(&q, &buf)?:buf) == data[3]);
+                CHECK(faa_queue_dequeue(&q, &buf) == -1);
+                CHECK(errno == ENOENT);
+            }
+        }
+
+        faa_queue_destroy(&q);
+    }
+}
+
+SCENARIO("セグメントをまたいでデータを追加/取得できること",
+         tags("faa_queue", "faa_queue_enqueue", "faa_queue_dequeue", "reusable")) {
+
+    GIVEN("キューを作成する") {
+        faa_queue_t q;
+
+        REQUIRE(faa_queue_create(&q, sizeof(int)) == 0);
+
+        WHEN("セグメント３つ分を超えるデータを追加する") {
+            static const int TEST_COUNT = FAA_SEGMENT_CELLS * 3 + 10;
+            for (int i = 0; i < TEST_COUNT; ++i) {
+                REQUIRE(faa_queue_enqueue(&q, &i) == 0);
+            }
+
+            THEN("追加した順にすべて取得できること") {
+                int *buf = (int *)faa_queue_to_array(&q);
+                REQUIRE(buf != NULL);
+                CHECK(buf[TEST_COUNT - 1] == TEST_COUNT - 1);
+                free(buf);
+
+                int mismatches = 0;
+                for (int i = 0; i < TEST_COUNT; ++i) {
+                    int v;
+                    if ((faa_queue_dequeue(&q, &v)?:v) != i) {
+                        ++mismatches;
+                    }
+                }
+                CHECK(mismatches == 0);
+                int v;
+                CHECK(faa_queue_dequeue(&q, &v) == -1);
+                CHECK(errno == ENOENT);
+            }
+        }
+
+        WHEN("空になるまでの追加/取得を何度も繰り返す") {
+
+            THEN("データが追加/取得できること") {
+                int mismatches = 0;
+                for (int i = 0; i < FAA_SEGMENT_CELLS * 10; i += 3) {
+                    int data, buf;
+                    CHECK((data = i, faa_queue_enqueue(&q, &data)) == 0);
+                    CHECK((data = i + 1, faa_queue_enqueue(&q, &data)) == 0);
+                    CHECK((data = i + 2, faa_queue_enqueue(&q, &data)) == 0);
+                    mismatches += ((faa_queue_dequeue(&q, &buf)?:buf) != i);
+                    mismatches += ((faa_queue_dequeue(&q, &buf)?:buf) != i + 1);
+                    mismatches += ((faa_queue_dequeue(&q, &buf)?:buf) != i + 2);
+                    mismatches += (faa_queue_dequeue(&q, &buf) != -1);
+                }
+                CHECK(mismatches == 0);
+            }
+        }
+
+        faa_queue_destroy(&q);
+    }
+}
+
+SCENARIO("キューへの並列アクセスが可能であること",
+         tags("faa_queue", "faa_queue_enqueue", "faa_queue_dequeue", "parallel")) {
+
+    GIVEN("キューを作成する") {
+        faa_queue_t q;
+
+        REQUIRE(faa_queue_create(&q, sizeof(int)) == 0);
+
+        struct param {
+            int count;
+            int offset;
+            std::function<int(int)> callback;
+        };
+        auto worker = [&](void *arg) -> void * {
+            struct param *prm = (struct param *)arg;
+            for (int i = 0; i < prm->count; ++i) {
+                if (prm->callback(prm->offset + i) != 0) {
+                    return (void *)(intptr_t)i;
+                }
+            }
+            return (void *)(intptr_t)prm->count;
+        };
+
+        WHEN("４つのスレッドから同時に追加/取得する") {
+            static const int TEST_COUNT = 10000;
+
+            auto pusher = [&](int data) -> int {
+                return faa_queue_enqueue(&q, &data);
+            };
+            BITFLAG bf = bitflag_create(TEST_COUNT * 2);
+            auto poper = [&](int) -> int {
+                int buf = -1;
+                while (faa_queue_dequeue(&q, &buf) != 0) {
+                    sched_yield();
+                }
+                return bitflag_set(bf, buf);
+            };
+
+            pthread_t thr[4];
+            struct param prm[4] = {
+                {.count = TEST_COUNT, .offset = 0, .callback = pusher},
+                {.count = TEST_COUNT, .offset = TEST_COUNT, .callback = pusher},
+                {.count = TEST_COUNT, .offset = 0, .callback = poper},
+                {.count = TEST_COUNT, .offset = 0, .callback = poper},
+            };
+            for (int i = 0; i < 4; ++i) {
+                REQUIRE(pthread_create(&thr[i], NULL, Lambda::ptr<void *, void *>(worker), &prm[i]) == 0);
+            }
+
+            THEN("データが追加/取得できること") {
+                intptr_t count = 0;
+                for (int i = 0; i < 4; ++i) {
+                    REQUIRE((pthread_join(thr[i], (void **)&count)?:count) == TEST_COUNT);
+                }
+
+                bool is_all_set = true;
+                for (int i = 0; i < (TEST_COUNT * 2); ++i) {
+                    if (!bitflag_check(bf, i)) {
+                        is_all_set = false;
+                    }
+                }
+                CHECK(is_all_set == true);
+                int buf;
+                CHECK(faa_queue_dequeue(&q, &buf) == -1);
+            }
+
+            bitflag_destroy(bf);
+        }
+
+        faa_queue_destroy(&q);
+    }
+}
+
+SCENARIO("同時に動く操作が SMR のレコード数を超えても待たされないこと",
+         tags("faa_queue", "faa_queue_enqueue", "faa_queue_dequeue")) {
+
+    GIVEN("キューを作成する") {
+        faa_queue_t q;
+
+        REQUIRE(faa_queue_create(&q, sizeof(int)) == 0);
+
+        WHEN("レコード２ブロック分を超える操作が実行中の状態にする") {
+            static const int HELD = SMR_BLOCK_RECORDS * 2 + 1;
+            struct smr_record *held[HELD];
+            for (int i = 0; i < HELD; ++i) {
+                held[i] = smr_enter(&q.smr);
+                REQUIRE(held[i] != NULL);
+            }
+
+            THEN("さらに追加/取得できること") {
+                int data = 10, buf = -1;
+                CHECK(faa_queue_enqueue(&q, &data) == 0);
+                CHECK(faa_queue_dequeue(&q, &buf) == 0);
+                CHECK(buf == 10);
+                CHECK(q.smr.nrecords >= (uint32_t)HELD + 1);
+            }
+
+            for (int i = 0; i < HELD; ++i) {
+                smr_leave(&q.smr, held[i]);
+            }
+        }
+
+        faa_queue_destroy(&q);
+    }
+}
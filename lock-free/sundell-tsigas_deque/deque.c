@@ -13,10 +13,12 @@
  *
  *  This code is licensed under the MIT License.
  */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdatomic.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <inttypes.h>
 #include <string.h>
@@ -29,48 +31,63 @@
 #include "mempool.h"
 #include "deque.h"
 
-typedef struct deque_link Link;
+/*
+ *  A link is a single word: the node pointer with the deletion mark in
+ *  bit 0, which is always clear in the pointer of an aligned node.
+ */
+typedef uintptr_t Link;
 typedef struct deque_node Node;
 
-struct deque_link {
-    Node *p;
-    bool d;
-};
-
+/*
+ *  ref holds twice the number of references, plus 1 while the node is in
+ *  use, so that the zero-filled pool starts out free. A thread may still
+ *  count a reference to a node that went back to the pool (DEREF() reads
+ *  the link first); such counts come and go in pairs and never make a
+ *  free node look released. The pool writes only the words before ref
+ *  of a free node (prev, and next too when it names fragments by
+ *  pointer), never ref itself. A link's reference is counted before the
+ *  CAS that stores it and dropped again if the CAS fails.
+ *
+ *  With DEQUE_FLAG_EPOCH only the links and the creator hold counted
+ *  references (COPY_LINK()/REL_LINK()); what an operation reads is kept
+ *  alive by its epoch, and DEREF()/COPY()/REL() touch nothing. A node
+ *  whose count drops to zero is retired, but a thread that read it may
+ *  still link it again (prev hints are allowed to lag), so ref also
+ *  counts the retirements not yet through (REF_PENDING), and only the
+ *  last of them, finding no links, releases the node.
+ */
 struct deque_node {
-    alignas(16) Link prev;
-    alignas(16) Link next;
-    alignas(16) uint32_t ref;
+    Link prev;
+    Link next;
+    uint64_t ref;
     uint8_t data[];
 };
 
-#define NODE_MAKER()   \
-    (Node){            \
-        .ref = 0,      \
-        .prev = {      \
-            .p = NULL, \
-            .d = false,\
-        },             \
-        .next = {      \
-            .p = NULL, \
-            .d = false,\
-        },             \
-    }
+_Static_assert(offsetof(struct deque_node, ref) >= sizeof(struct memory_node),
+               "a free node's ref must survive the pool's link");
 
-#define LINK_MAKER(a, b) (Link)({Link c={0};c.p=(a),c.d=(b),c;})
+#define REF_ONE     UINT64_C(2)
+#define REF_IN_USE  UINT64_C(1)
+#define REF_COUNT   UINT64_C(0xfffffffe)
+#define REF_PENDING (UINT64_C(1) << 32)
+
+#define LINK_MAKER(a, b) ((Link)(uintptr_t)(a) | (Link)((b) ? 1 : 0))
+#define LINK_P(l) ((Node *)((l) & ~(Link)1))
+#define LINK_D(l) ((bool)((l) & 1))
 
 static inline
 void deque_node_dump(const char *name, Node *val)
 {
-    printf("@ %s(%p): {ref=%u, prev={p=%p, d=%d}, next={p=%p, d=%d}, data={...}}\n",
-           name, val, val->ref, val->prev.p, val->prev.d, val->next.p, val->next.d);
+    printf("@ %s(%p): {ref=%" PRIu64 ", prev={p=%p, d=%d}, next={p=%p, d=%d}, data={...}}\n",
+           name, val, val->ref, LINK_P(val->prev), (int)LINK_D(val->prev),
+           LINK_P(val->next), (int)LINK_D(val->next));
 }
 
 static inline
 void deque_link_dump(const char *name, Link val)
 {
     printf("@ %s: {p=%p, d=%d}\n",
-           name, val.p, val.d);
+           name, LINK_P(val), (int)LINK_D(val));
 }
 
 #if 0
@@ -83,66 +100,238 @@ void deque_link_dump(const char *name, Link val)
 #define dump(v)
 #endif
 
+/*
+ *  DEQUE_FLAG_EPOCH: the record of the operation this thread is in, and
+ *  the nodes its scans released, chained through ref, whose links are
+ *  dropped once the scan is over.
+ */
+static __thread struct smr_record *current;
+static __thread Node *dead;
+
+static inline bool epoch_mode(struct deque *self)
+{
+    return (self->flags & DEQUE_FLAG_EPOCH) != 0;
+}
+
 bool CAS(Link *a, Link b, Link c)
 {
-    return atomic_compare_exchange_weak(a, &b, c);
+    return atomic_compare_exchange_strong(a, &b, c);
+}
+
+void REL_LINK(struct deque *self, Node *node);
+void TerminateNode(struct deque *self, Node *node);
+
+/**
+ *  Terminates and frees the nodes released by the scans of this operation.
+ */
+static void bury_dead(struct deque *self)
+{
+    while (dead != NULL) {
+        Node *node = dead;
+        dead = (Node *)(uintptr_t)atomic_load(&node->ref);
+        atomic_store(&node->ref, 0);
+        TerminateNode(self, node);
+        mempool_free(&self->pool, node);
+    }
+}
+
+/**
+ *  Starts an operation; with epochs, enters one.
+ *
+ *  @return Returns true if succeed, false if no record was available.
+ */
+static inline bool deque_enter(struct deque *self)
+{
+    if (epoch_mode(self)) {
+        current = smr_enter(&self->smr);
+        return current != NULL;
+    }
+    return true;
 }
 
+static inline void deque_leave(struct deque *self)
+{
+    if (epoch_mode(self)) {
+        bury_dead(self);
+        smr_leave(&self->smr, current);
+        current = NULL;
+    }
+}
+
+/**
+ *  Reclaims a retired node: unless it was linked again or retired once
+ *  more meanwhile, it is released. Runs inside smr_scan(), so the links
+ *  of the node are left to bury_dead().
+ */
+static void reclaim_node(void *ptr, void *arg)
+{
+    UNUSED_VARIABLE(arg);
+
+    Node *node = (Node *)ptr;
+    uint64_t ref = atomic_load(&node->ref);
+    uint64_t next;
+    do {
+        next = ref - REF_PENDING;
+        if (next == REF_IN_USE) {
+            next = 0;
+        }
+    } while (!atomic_compare_exchange_weak(&node->ref, &ref, next));
+
+    if (next == 0) {
+        atomic_store(&node->ref, (uint64_t)(uintptr_t)dead);
+        dead = node;
+    }
+}
+
+/**
+ *  Takes a node from the pool, holding one reference for the caller.
+ *  With epochs, a dry pool first has the retired nodes reclaimed. Must
+ *  be called outside deque_enter()/deque_leave().
+ */
 Node *MALLOC_NODE(struct deque *self)
 {
-    Node *n = mempool_alloc(&self->pool);
-    if (n == NULL) {
-        return NULL;
+    Node *n;
+    while ((n = mempool_alloc(&self->pool)) == NULL) {
+        if (!epoch_mode(self) || (smr_collect(&self->smr) == 0)) {
+            return NULL;
+        }
+        if (deque_enter(self)) {
+            deque_leave(self);
+        }
     }
 
-    *n = NODE_MAKER();
+    n->prev = LINK_MAKER(NULL, false);
+    n->next = LINK_MAKER(NULL, false);
+    /* added, not stored: stale references may be counted meanwhile. */
+    atomic_fetch_add(&n->ref, REF_ONE + REF_IN_USE);
 
     return n;
 }
 
-Node *DEREF(Link *link)
+/**
+ *  Gives back a node that was never linked.
+ */
+static inline void FREE_NODE(struct deque *self, Node *node)
 {
-    Link link1 = atomic_load(link);
-    if (link1.d) {
-        return NULL;
-    } else {
-        atomic_inc(&link1.p->ref);
-dump(link1.p);
-        return link1.p;
+    atomic_store(&node->ref, 0);
+    mempool_free(&self->pool, node);
+}
+
+/**
+ *  Counts a reference to the node @c link names, unless it is marked.
+ *  The link is read again afterwards, so that the node cannot have been
+ *  released in between.
+ */
+Node *DEREF(struct deque *self, Link *link)
+{
+    if (epoch_mode(self)) {
+        Link link1 = atomic_load(link);
+        return LINK_D(link1) ? NULL : LINK_P(link1);
+    }
+
+    while (true) {
+        Link link1 = atomic_load(link);
+        if (LINK_D(link1)) {
+            return NULL;
+        }
+        atomic_fetch_add(&LINK_P(link1)->ref, REF_ONE);
+        if (atomic_load(link) == link1) {
+dump(LINK_P(link1));
+            return LINK_P(link1);
+        }
+        REL_LINK(self, LINK_P(link1));
     }
 }
 
-Node *DEREF_D(Link *link)
+/**
+ *  DEREF() that follows marked links too.
+ */
+Node *DEREF_D(struct deque *self, Link *link)
 {
-    Link link1 = atomic_load(link);
-    atomic_inc(&link1.p->ref);
-dump(link1.p);
-    return link1.p;
+    if (epoch_mode(self)) {
+        return LINK_P(atomic_load(link));
+    }
+
+    while (true) {
+        Link link1 = atomic_load(link);
+        atomic_fetch_add(&LINK_P(link1)->ref, REF_ONE);
+        if (LINK_P(atomic_load(link)) == LINK_P(link1)) {
+dump(LINK_P(link1));
+            return LINK_P(link1);
+        }
+        REL_LINK(self, LINK_P(link1));
+    }
 }
 
-Node *COPY(Node *node)
+/**
+ *  Counts a reference for a link about to name @c node.
+ */
+Node *COPY_LINK(Node *node)
 {
-    atomic_inc(&node->ref);
+    atomic_fetch_add(&node->ref, REF_ONE);
 dump(node);
     return node;
 }
 
-void TerminateNode(Node *);
+/**
+ *  Counts a local reference, as DEREF() does.
+ */
+Node *COPY(struct deque *self, Node *node)
+{
+    if (!epoch_mode(self)) {
+        COPY_LINK(node);
+    }
+    return node;
+}
 
-void REL(Node *node)
+/**
+ *  Drops a counted reference. With reference counts, the thread that
+ *  drops the last one and then clears REF_IN_USE, ahead of any stale
+ *  reference, releases the node's links and gives it back to the pool.
+ *  With epochs, the node is retired instead.
+ */
+void REL_LINK(struct deque *self, Node *node)
 {
     if (node == NULL) {
         ERROR("node is NULL!!!");
         return;
     }
 
-    uint32_t ref = atomic_fetch_sub(&node->ref, 1);
+    if (epoch_mode(self)) {
+        uint64_t ref = atomic_load(&node->ref);
+        uint64_t next;
+        do {
+            next = ref - REF_ONE;
+            if ((next & REF_COUNT) == 0) {
+                next += REF_PENDING;
+            }
+        } while (!atomic_compare_exchange_weak(&node->ref, &ref, next));
+        if ((next & REF_COUNT) == 0) {
+            smr_retire(&self->smr, current, node);
+        }
+        return;
+    }
+
+    uint64_t ref = atomic_fetch_sub(&node->ref, REF_ONE);
 dump(node);
-    if (ref == 1) {
-        TerminateNode(node);
+    if (ref != REF_ONE + REF_IN_USE) {
+        return;
+    }
+    uint64_t expected = REF_IN_USE;
+    if (atomic_compare_exchange_strong(&node->ref, &expected, 0)) {
+        TerminateNode(self, node);
+        mempool_free(&self->pool, node);
     }
+}
 
-    /* TODO: free node? */
+/**
+ *  Drops a local reference.
+ */
+void REL(struct deque *self, Node *node)
+{
+    if (!epoch_mode(self)) {
+        REL_LINK(self, node);
+    }
 }
 
 Node *CreateNode(struct deque *self, const void *val)
@@ -157,14 +346,25 @@ Node *CreateNode(struct deque *self, const void *val)
     return n;
 }
 
-void TerminateNode(Node *node)
+void TerminateNode(struct deque *self, Node *node)
 {
 dump(node);
-    REL(atomic_load(&node->prev).p);
-    REL(atomic_load(&node->next).p);
+    Node *prev = LINK_P(atomic_load(&node->prev));
+    Node *next = LINK_P(atomic_load(&node->next));
+    if (prev != NULL) {
+        REL_LINK(self, prev);
+    }
+    if (next != NULL) {
+        REL_LINK(self, next);
+    }
 }
 
 int deque_create(deq_t *q, size_t val_bytes, size_t capacity)
+{
+    return deque_create_flags(q, val_bytes, capacity, 0);
+}
+
+int deque_create_flags(deq_t *q, size_t val_bytes, size_t capacity, unsigned int flags)
 {
     if ((q == NULL) || (val_bytes == 0) || (capacity == 0)) {
         errno = EINVAL;
@@ -173,17 +373,20 @@ int deque_create(deq_t *q, size_t val_bytes, size_t capacity)
 
     struct deque *self = (struct deque *)q;
 
-    size_t node_bytes = sizeof(*self->head) * val_bytes;
+    size_t node_bytes = sizeof(*self->head) + val_bytes;
     int ret = mempool_create(&self->pool, node_bytes, capacity + 2);
     if (ret != 0) {
         return -1;
     }
     self->val_bytes = val_bytes;
+    self->flags = flags;
+    smr_init(&self->smr, SMR_EPOCH, reclaim_node, self);
 
+    /* self->head and self->tail hold one reference each, the links another. */
     self->head = MALLOC_NODE(self);
     self->tail = MALLOC_NODE(self);
-    self->head->next.p = self->tail;
-    self->tail->prev.p = self->head;
+    self->head->next = LINK_MAKER(COPY_LINK(self->tail), false);
+    self->tail->prev = LINK_MAKER(COPY_LINK(self->head), false);
 
     return 0;
 }
@@ -197,6 +400,9 @@ int deque_destroy(deq_t *q)
 
     struct deque *self = (struct deque *)q;
 
+    /* the pool goes away as a whole, the nodes released here with it. */
+    smr_destroy(&self->smr);
+    dead = NULL;
     mempool_destroy(&self->pool);
 
     return 0;
@@ -207,182 +413,196 @@ void deque_mark_prev(Node *node)
     while (true) {
         Link link1 = atomic_load(&node->prev);
 
-        if (link1.d || CAS(&node->prev, link1, LINK_MAKER(link1.p, true))) {
+        if (LINK_D(link1) || CAS(&node->prev, link1, LINK_MAKER(LINK_P(link1), true))) {
             break;
         }
     }
 }
 
-void HelpDelete(Node *node)
+void HelpDelete(struct deque *self, Node *node)
 {
     deque_mark_prev(node);
 
     Node *last = NULL;
-    Node *prev = DEREF_D(&node->prev);
-    Node *next = DEREF_D(&node->next);
+    Node *prev = DEREF_D(self, &node->prev);
+    Node *next = DEREF_D(self, &node->next);
     Node *next2;
 
     while (true) {
         if (prev == next) {
             break;
         }
-        if (next->next.d) {
+        if (LINK_D(next->next)) {
             deque_mark_prev(next);
-            next2 = DEREF_D(&next->next);
-            REL(next);
+            next2 = DEREF_D(self, &next->next);
+            REL(self, next);
             next = next2;
             continue;
         }
 
-        Node *prev2 = DEREF(&prev->next);
+        Node *prev2 = DEREF(self, &prev->next);
         if (prev2 == NULL) {
             if (last != NULL) {
                 deque_mark_prev(prev);
-                next2 = DEREF_D(&prev->next);
+                next2 = DEREF_D(self, &prev->next);
+                COPY_LINK(next2);
                 if (CAS(&last->next, LINK_MAKER(prev, false),
                         LINK_MAKER(next2, false))) {
-                    REL(prev);
+                    REL_LINK(self, prev);
                 } else {
-                    REL(next2);
+                    REL_LINK(self, next2);
                 }
-                REL(prev);
+                REL(self, next2);
+                REL(self, prev);
                 prev = last;
                 last = NULL;
             } else {
-                prev2 = DEREF_D(&prev->prev);
-                REL(prev);
+                prev2 = DEREF_D(self, &prev->prev);
+                REL(self, prev);
                 prev = prev2;
             }
             continue;
         }
         if (prev2 != node) {
             if (last != NULL) {
-                REL(last);
+                REL(self, last);
             }
             last = prev;
             prev = prev2;
             continue;
         }
-        REL(prev2);
+        REL(self, prev2);
 
+        COPY_LINK(next);
         if (CAS(&prev->next, LINK_MAKER(node, false),
                 LINK_MAKER(next, false))) {
-            COPY(next);
-            REL(node);
+            REL_LINK(self, node);
             break;
         }
+        REL_LINK(self, next);
     }
 
     if (last != NULL) {
-        REL(last);
+        REL(self, last);
     }
-    REL(prev);
-    REL(next);
+    REL(self, prev);
+    REL(self, next);
 }
 
-Node *HelpInsert(Node *prev, Node *node)
+Node *HelpInsert(struct deque *self, Node *prev, Node *node)
 {
     Node *last = NULL;
 
     while (true) {
-        Node *prev2 = DEREF(&prev->next);
+        Node *prev2 = DEREF(self, &prev->next);
         if (prev2 == NULL) {
             if (last != NULL) {
                 deque_mark_prev(prev);
-                Node *next2 = DEREF_D(&prev->next);
+                Node *next2 = DEREF_D(self, &prev->next);
+                COPY_LINK(next2);
                 if (CAS(&last->next, LINK_MAKER(prev, false),
                         LINK_MAKER(next2, false))) {
-                    REL(prev);
+                    REL_LINK(self, prev);
                 } else {
-                    REL(next2);
+                    REL_LINK(self, next2);
                 }
-                REL(prev);
+                REL(self, next2);
+                REL(self, prev);
                 prev = last;
                 last = NULL;
             } else {
-                prev2 = DEREF_D(&prev->prev);
-                REL(prev);
+                prev2 = DEREF_D(self, &prev->prev);
+                REL(self, prev);
                 prev = prev2;
             }
             continue;
         }
 
         Link link1 = atomic_load(&node->prev);
-        if (link1.d) {
-            REL(prev2);
+        if (LINK_D(link1)) {
+            REL(self, prev2);
             break;
         }
         if (prev2 != node) {
             if (last != NULL) {
-                REL(last);
+                REL(self, last);
             }
             last = prev;
             prev = prev2;
             continue;
         }
-        REL(prev2);
+        REL(self, prev2);
 
-        if (link1.p == prev) {
+        if (LINK_P(link1) == prev) {
             break;
         }
-        if ((atomic_load(&prev->next).p == node)
-            && CAS(&node->prev, link1, LINK_MAKER(prev, false))) {
-            COPY(prev);
-            REL(link1.p);
-            if (!prev->prev.d) {
+        if (LINK_P(atomic_load(&prev->next)) != node) {
+            continue;
+        }
+        COPY_LINK(prev);
+        if (CAS(&node->prev, link1, LINK_MAKER(prev, false))) {
+            REL_LINK(self, LINK_P(link1));
+            if (!LINK_D(prev->prev)) {
                 break;
             }
+            continue;
         }
+        REL_LINK(self, prev);
     }
 
     if (last != NULL) {
-        REL(last);
+        REL(self, last);
     }
 
     return prev;
 }
 
-void RemoveCrossReference(Node *node)
+void RemoveCrossReference(struct deque *self, Node *node)
 {
     while (true) {
-        Node *prev = atomic_load(&node->prev).p;
-        if (atomic_load(&prev->prev).d) {
-            Node *prev2 = DEREF_D(&prev->prev);
-            node->prev = LINK_MAKER(prev2, true);
-            REL(prev);
+        Node *prev = LINK_P(atomic_load(&node->prev));
+        if (LINK_D(atomic_load(&prev->next))) {
+            Node *prev2 = DEREF_D(self, &prev->prev);
+            node->prev = LINK_MAKER(COPY_LINK(prev2), true);
+            REL_LINK(self, prev);
+            REL(self, prev2);
             continue;
         }
 
-        Node *next = atomic_load(&node->next).p;
-        if (atomic_load(&next->prev).d) {
-            Node *next2 = DEREF_D(&next->next);
-            node->next = LINK_MAKER(next2, true);
+        Node *next = LINK_P(atomic_load(&node->next));
+        if (LINK_D(atomic_load(&next->next))) {
+            Node *next2 = DEREF_D(self, &next->next);
+            node->next = LINK_MAKER(COPY_LINK(next2), true);
+            REL_LINK(self, next);
+            REL(self, next2);
             continue;
         }
         break;
     }
 }
 
-void deque_push_common(Node *node, Node *next)
+void deque_push_common(struct deque *self, Node *node, Node *next)
 {
     while (true) {
         Link link1 = atomic_load(&next->prev);
-        if (link1.d || ((node->next.p != next) || node->next.d)) {
+        if (LINK_D(link1) || (node->next != LINK_MAKER(next, false))) {
             break;
         }
+        COPY_LINK(node);
         if (CAS(&next->prev, link1, LINK_MAKER(node, false))) {
-            COPY(node);
-            REL(link1.p);
-            if (node->prev.d) {
-                Node *prev2 = COPY(node);
-                prev2 = HelpInsert(prev2, next);
-                REL(prev2);
+            REL_LINK(self, LINK_P(link1));
+            if (LINK_D(node->prev)) {
+                Node *prev2 = COPY(self, node);
+                prev2 = HelpInsert(self, prev2, next);
+                REL(self, prev2);
             }
             break;
         }
+        REL_LINK(self, node);
     }
-    REL(next);
-    REL(node);
+    REL(self, next);
+    /* the creator's reference, counted in either mode. */
+    REL_LINK(self, node);
 }
 
 int deque_push(deq_t *q, const void *val)
@@ -398,27 +618,36 @@ int deque_push(deq_t *q, const void *val)
     if (node == NULL) {
         return -1;
     }
+    if (!deque_enter(self)) {
+        FREE_NODE(self, node);
+        return -1;
+    }
 
-    Node *prev = COPY(self->head);
-    Node *next = DEREF(&prev->next);
+    Node *prev = COPY(self, self->head);
+    Node *next = DEREF(self, &prev->next);
+    node->prev = LINK_MAKER(COPY_LINK(prev), false);
     while (true) {
-        if ((prev->next.p != next) || prev->next.d) {
-            REL(next);
-            next = DEREF(&prev->next);
+        if (prev->next != LINK_MAKER(next, false)) {
+            REL(self, next);
+            next = DEREF(self, &prev->next);
             continue;
         }
-        node->prev = LINK_MAKER(prev, false);
+        /* the count of prev->next moves over with the CAS. */
         node->next = LINK_MAKER(next, false);
 
+        /* counted up front: once linked, the node may be popped at once. */
+        COPY_LINK(node);
         if (CAS(&prev->next,
                 LINK_MAKER(next, false),
                 LINK_MAKER(node, false))) {
-            COPY(node);
             break;
         }
+        REL_LINK(self, node);
     }
+    REL(self, prev);
 
-    deque_push_common(node, next);
+    deque_push_common(self, node, next);
+    deque_leave(self);
 
     return 0;
 }
@@ -436,24 +665,33 @@ int deque_shift(deq_t *q, const void *val)
     if (node == NULL) {
         return -1;
     }
+    if (!deque_enter(self)) {
+        FREE_NODE(self, node);
+        return -1;
+    }
 
-    Node *next = COPY(self->tail);
-    Node *prev = DEREF(&next->prev);
+    Node *next = COPY(self, self->tail);
+    Node *prev = DEREF(self, &next->prev);
     while (true) {
-        if ((prev->next.p != next) || prev->next.d) {
-            prev = HelpInsert(prev, next);
+        if (prev->next != LINK_MAKER(next, false)) {
+            prev = HelpInsert(self, prev, next);
             continue;
         }
         node->prev = LINK_MAKER(prev, false);
         node->next = LINK_MAKER(next, false);
 
+        COPY_LINK(prev);
+        COPY_LINK(node);
         if (CAS(&prev->next, LINK_MAKER(next, false), LINK_MAKER(node, false))) {
-            COPY(node);
             break;
         }
+        REL_LINK(self, node);
+        REL_LINK(self, prev);
     }
+    REL(self, prev);
 
-    deque_push_common(node, next);
+    deque_push_common(self, node, next);
+    deque_leave(self);
 
     return 0;
 }
@@ -467,36 +705,42 @@ int deque_pop(deq_t *q, void *val)
 
     struct deque *self = (struct deque *)q;
 
+    if (!deque_enter(self)) {
+        return -1;
+    }
+
     Node *node;
-    Node *prev = COPY(self->head);
+    Node *prev = COPY(self, self->head);
     while (true) {
-        node = DEREF(&prev->next);
+        node = DEREF(self, &prev->next);
         if (node == self->tail) {
-            REL(node);
-            REL(prev);
+            REL(self, node);
+            REL(self, prev);
+            deque_leave(self);
             errno = ENOENT;
             return -1;
         }
         Link link1 = atomic_load(&node->next);
-        if (link1.d) {
-            HelpDelete(node);
-            REL(node);
+        if (LINK_D(link1)) {
+            HelpDelete(self, node);
+            REL(self, node);
             continue;
         }
-        if (CAS(&node->next, link1, LINK_MAKER(link1.p, true))) {
-            HelpDelete(node);
-            Node *next = DEREF_D(&node->next);
-            prev = HelpInsert(prev, next);
-            REL(prev);
-            REL(next);
+        if (CAS(&node->next, link1, LINK_MAKER(LINK_P(link1), true))) {
+            HelpDelete(self, node);
+            Node *next = DEREF_D(self, &node->next);
+            prev = HelpInsert(self, prev, next);
+            REL(self, prev);
+            REL(self, next);
             memcpy(val, node->data, self->val_bytes);
             break;
         }
-        REL(node);
+        REL(self, node);
     }
 
-    RemoveCrossReference(node);
-    REL(node);
+    RemoveCrossReference(self, node);
+    REL(self, node);
+    deque_leave(self);
 
     return 0;
 }
@@ -510,32 +754,38 @@ int deque_unshift(deq_t *q, void *val)
 
     struct deque *self = (struct deque *)q;
 
-    Node *next = COPY(self->tail);
-    Node *node = DEREF(&next->prev);
+    if (!deque_enter(self)) {
+        return -1;
+    }
+
+    Node *next = COPY(self, self->tail);
+    Node *node = DEREF(self, &next->prev);
     while (true) {
-        if ((node->next.p != next) || node->next.d) {
-            node = HelpInsert(node, next);
+        if (node->next != LINK_MAKER(next, false)) {
+            node = HelpInsert(self, node, next);
             continue;
         }
         if (node == self->head) {
-            REL(node);
-            REL(next);
+            REL(self, node);
+            REL(self, next);
+            deque_leave(self);
             errno = ENOENT;
             return -1;
         }
         if (CAS(&node->next, LINK_MAKER(next, false), LINK_MAKER(next, true))) {
-            HelpDelete(node);
-            Node *prev = DEREF_D(&node->prev);
-            prev = HelpInsert(prev, next);
-            REL(prev);
-            REL(next);
+            HelpDelete(self, node);
+            Node *prev = DEREF_D(self, &node->prev);
+            prev = HelpInsert(self, prev, next);
+            REL(self, prev);
+            REL(self, next);
             memcpy(val, node->data, self->val_bytes);
             break;
         }
     }
 
-    RemoveCrossReference(node);
-    REL(node);
+    RemoveCrossReference(self, node);
+    REL(self, node);
+    deque_leave(self);
 
     return 0;
 }
@@ -553,7 +803,7 @@ void *deque_to_array(deq_t *q)
     size_t size = self->val_bytes;
     uint8_t *ptr = (uint8_t *)calloc(n, size);
     int i = 0;
-    for (Node *node = self->head->next.p; node != self->tail; node = node->next.p, ++i) {
+    for (Node *node = LINK_P(self->head->next); node != self->tail; node = LINK_P(node->next), ++i) {
         memcpy(&ptr[size * i], node->data, size);
     }
 
@@ -563,7 +813,7 @@ void *deque_to_array(deq_t *q)
 void deque_dump(deq_t *q)
 {
     int i = 0;
-    for (Node *node = q->head->next.p; node != q->tail; node = node->next.p, ++i) {
+    for (Node *node = LINK_P(q->head->next); node != q->tail; node = LINK_P(node->next), ++i) {
         printf("[%d]: %d\n", i, *(int *)node->data);
     }
 }
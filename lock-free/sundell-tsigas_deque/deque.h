@@ -17,6 +17,7 @@
 #define __ALGORITHMS_INTERNAL_DEQUE_H__
 
 #include "mempool.h"
+#include "smr.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -24,14 +25,24 @@ extern "C" {
 
 struct deque_node;
 
+/*
+ *  protect the nodes an operation reads with epochs instead of counting
+ *  every reference to them; only the links stay counted.
+ */
+#define DEQUE_FLAG_EPOCH (1U << 0)
+
 typedef struct deque {
-    mpool_t pool;
-    size_t val_bytes;
+    /* read-only after creation; kept off the pool's counter line. */
+    alignas(CACHE_LINE_BYTES) size_t val_bytes;
     struct deque_node *head;
     struct deque_node *tail;
+    unsigned int flags;
+    mpool_t pool;
+    struct smr_domain smr;      /* DEQUE_FLAG_EPOCH: unlinked nodes wait here. */
 } deq_t;
 
 int deque_create(deq_t *q, size_t val_bytes, size_t capacity);
+int deque_create_flags(deq_t *q, size_t val_bytes, size_t capacity, unsigned int flags);
 int deque_destroy(deq_t *q);
 int deque_push(deq_t *q, const void *val);
 int deque_pop(deq_t *q, void *val);
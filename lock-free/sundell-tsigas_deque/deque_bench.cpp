@@ -0,0 +1,64 @@
+/** @file       deque_bench.cpp
+ *  @brief      Benchmark for Deque.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+#include "utils.hpp"
+
+#include "mempool.h"
+#include "deque.h"
+
+SCENARIO("メモリプールの操作コストを計測する", tags(".", "benchmark", "mempool_alloc", "mempool_free")) {
+
+    GIVEN("メモリプールを作成する") {
+        mpool_t mp;
+
+        REQUIRE(mempool_create(&mp, sizeof(int), 1024) == 0);
+
+        BENCHMARK("alloc / free") {
+            void *ptr = mempool_alloc(&mp);
+            mempool_free(&mp, ptr);
+            return ptr;
+        };
+
+        mempool_destroy(&mp);
+    }
+}
+
+SCENARIO("両端キューの操作コストを計測する", tags(".", "benchmark", "deque_push", "deque_pop")) {
+
+    GIVEN("サイズの十分な両端キューを作成する") {
+        deq_t q;
+
+        REQUIRE(deque_create(&q, sizeof(int), 1024) == 0);
+
+        BENCHMARK("push / pop") {
+            int data = 10, buf;
+            deque_push(&q, &data);
+            return deque_pop(&q, &buf);
+        };
+
+        deque_destroy(&q);
+    }
+
+    GIVEN("サイズの十分な両端キューをエポック指定で作成する") {
+        deq_t q;
+
+        REQUIRE(deque_create_flags(&q, sizeof(int), 1024, DEQUE_FLAG_EPOCH) == 0);
+
+        BENCHMARK("push / pop (epoch)") {
+            int data = 10, buf;
+            deque_push(&q, &data);
+            return deque_pop(&q, &buf);
+        };
+
+        deque_destroy(&q);
+    }
+}
@@ -0,0 +1,53 @@
+/** @file       deque_coro.hpp
+ *  @brief      C++20 awaitable wrapper for the deque.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __ALGORITHMS_INTERNAL_DEQUE_CORO_HPP__
+#define __ALGORITHMS_INTERNAL_DEQUE_CORO_HPP__
+
+#include "awaitable.hpp"
+#include "deque.h"
+
+namespace algorithms {
+
+struct deque_ops {
+    using container_type = deq_t;
+
+    static int create(deq_t *q, size_t value_bytes, size_t capacity)
+    {
+        return deque_create(q, value_bytes, capacity);
+    }
+
+    static int destroy(deq_t *q)
+    {
+        return deque_destroy(q);
+    }
+
+    /* the node pool is fixed, so ENOMEM is full: a pop makes room. */
+    static int try_push(deq_t *q, const void *value)
+    {
+        return retry_on(deque_push(q, value), ENOMEM);
+    }
+
+    static int try_pop(deq_t *q, void *value)
+    {
+        return retry_on(deque_pop(q, value), ENOENT);
+    }
+};
+
+/**
+ *  Channel over one end of the deque, so last in first out:
+ *  `co_await q.push(v)` waits while the node pool is used up,
+ *  `co_await q.pop()` while empty.
+ */
+template <typename T, typename Executor = inline_executor>
+using coro_deque = awaitable_channel<deque_ops, T, Executor>;
+
+} // namespace algorithms
+
+#endif /* __ALGORITHMS_INTERNAL_DEQUE_CORO_HPP__ */
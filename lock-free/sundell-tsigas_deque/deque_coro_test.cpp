@@ -0,0 +1,92 @@
+/** @file       deque_coro_test.cpp
+ *  @brief      Unit-test for the deque awaitables (C++20).
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <catch2/catch.hpp>
+#include <coroutine>
+
+#include "utils.hpp"
+
+#include "deque_coro.hpp"
+
+using algorithms::coro_deque;
+
+/**
+ *  Coroutine that starts right away and frees itself when done.
+ */
+struct detached {
+    struct promise_type {
+        detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+static detached pop_into(coro_deque<int> &q, int *out, int *done)
+{
+    *out = co_await q.pop();
+    ++*done;
+}
+
+static detached push_from(coro_deque<int> &q, int value, int *done)
+{
+    co_await q.push(value);
+    ++*done;
+}
+
+SCENARIO("両端キューの追加/取得を co_await で待機できること",
+         tags("deque", "deque_coro", "coro_deque_push", "coro_deque_pop")) {
+
+    GIVEN("両端キューを作成する") {
+        coro_deque<int> q(4);
+
+        WHEN("データがある状態で取得する") {
+            int pushed = 0, popped = 0, out = -1;
+            push_from(q, 10, &pushed);
+            push_from(q, 11, &pushed);
+            pop_into(q, &out, &popped);
+
+            THEN("中断せずにその場で、後に追加したデータから取得できること") {
+                CHECK(pushed == 2);
+                CHECK(popped == 1);
+                CHECK(out == 11);
+            }
+        }
+
+        WHEN("空の状態で取得し、後から追加する") {
+            int pushed = 0, popped = 0, out = -1;
+            pop_into(q, &out, &popped);
+            CHECK(popped == 0);
+            push_from(q, 10, &pushed);
+
+            THEN("追加したスレッド上で再開され、データが取得できること") {
+                CHECK(pushed == 1);
+                CHECK(popped == 1);
+                CHECK(out == 10);
+            }
+        }
+
+        WHEN("ノードを使い切った状態で追加し、後から取得する") {
+            int pushed = 0, popped = 0, out = -1;
+            for (int i = 0; i < 5; ++i) {
+                push_from(q, 10 + i, &pushed);
+            }
+            CHECK(pushed == 4);
+
+            THEN("ノードが空いたところで追加が再開されること") {
+                pop_into(q, &out, &popped);
+                CHECK(out == 13);
+                CHECK(pushed == 5);
+                pop_into(q, &out, &popped);
+                CHECK(out == 14);
+            }
+        }
+    }
+}
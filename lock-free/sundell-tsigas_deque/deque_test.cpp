@@ -9,6 +9,7 @@
  */
 #include <sched.h>
 #include <pthread.h>
+#include <atomic>
 #include <catch2/catch.hpp>
 
 #include "utils.hpp"
@@ -49,6 +50,24 @@ SCENARIO("両端キューを作成できること", tags("deque", "deque_create"
     }
 }
 
+SCENARIO("両端キューのノードが小さいこと", tags("deque", "deque_create", "layout")) {
+
+    GIVEN("両端キューを作成する") {
+        deq_t q;
+
+        REQUIRE(deque_create(&q, sizeof(int), 1) == 0);
+
+        WHEN("ノード 1 つの大きさを調べる") {
+
+            THEN("1 ワードのリンク 2 つと参照数、データで済むこと") {
+                CHECK(mempool_data_bytes(&q.pool) <= (ssize_t)(3 * sizeof(void *) + sizeof(int)));
+            }
+        }
+
+        deque_destroy(&q);
+    }
+}
+
 SCENARIO("両端キューに最小数のデータを追加できること", tags("deque", "deque_push", "deque_shift", "minimum")) {
 
     GIVEN("サイズの十分な両端キューを作成する") {
@@ -416,6 +435,159 @@ SCENARIO("両端キューへのデータの追加/取得が繰り返しできる
     }
 }
 
+SCENARIO("取得済みのノードがプールに戻ること",
+         tags("deque", "deque_push", "deque_shift", "deque_pop", "deque_unshift", "reclaim")) {
+
+    GIVEN("容量の小さい両端キューを作成する") {
+        deq_t q;
+        size_t capacity{4};
+
+        INFO("容量: " + std::to_string(capacity));
+
+        REQUIRE(deque_create(&q, sizeof(int), capacity) == 0);
+
+        WHEN("容量を大きく超える回数、追加/取得を繰り返す") {
+
+            THEN("データが追加/取得でき、ノードがすべて戻ること") {
+                for (int i = 0; i < 10000; ++i) {
+                    int buf = -1;
+                    REQUIRE(deque_push(&q, &i) == 0);
+                    REQUIRE(deque_shift(&q, &i) == 0);
+                    REQUIRE((deque_pop(&q, &buf)?:buf) == i);
+                    REQUIRE((deque_unshift(&q, &buf)?:buf) == i);
+                }
+                CHECK(mempool_freeable(&q.pool) == (ssize_t)capacity);
+            }
+        }
+
+        deque_destroy(&q);
+    }
+
+    GIVEN("容量の小さい両端キューを作成する") {
+        deq_t q;
+        size_t capacity{256};
+        static const int TEST_COUNT = 10000;
+
+        INFO("容量: " + std::to_string(capacity));
+
+        REQUIRE(deque_create(&q, sizeof(int), capacity) == 0);
+
+        WHEN("４つのスレッドから同時に両端へ追加/取得を繰り返す") {
+            auto worker = [&](void *arg) -> void * {
+                intptr_t id = (intptr_t)arg;
+                for (int i = 0; i < TEST_COUNT; ++i) {
+                    int data = i, buf;
+                    int ret = (id % 2) ? deque_push(&q, &data) : deque_shift(&q, &data);
+                    if (ret != 0) {
+                        return (void *)(intptr_t)i;
+                    }
+                    while (((id / 2) ? deque_pop(&q, &buf) : deque_unshift(&q, &buf)) != 0) {
+                        sched_yield();
+                    }
+                    if ((i % 64) == 0) {
+                        sched_yield();
+                    }
+                }
+                return (void *)(intptr_t)TEST_COUNT;
+            };
+
+            pthread_t thr[4];
+            for (intptr_t t = 0; t < 4; ++t) {
+                REQUIRE(pthread_create(&thr[t], NULL, Lambda::ptr<void *, void *>(worker), (void *)t) == 0);
+            }
+
+            THEN("容量を使い切らず、ノードがすべて戻ること") {
+                for (int t = 0; t < 4; ++t) {
+                    intptr_t count = 0;
+                    CHECK((pthread_join(thr[t], (void **)&count)?:count) == TEST_COUNT);
+                }
+                CHECK(mempool_freeable(&q.pool) == (ssize_t)capacity);
+            }
+        }
+
+        deque_destroy(&q);
+    }
+}
+
+SCENARIO("エポックで保護する両端キューを使えること",
+         tags("deque", "deque_create_flags", "deque_push", "deque_shift", "deque_pop", "deque_unshift", "epoch")) {
+
+    GIVEN("容量の小さい両端キューをエポック指定で作成する") {
+        deq_t q;
+        size_t capacity{4};
+
+        INFO("容量: " + std::to_string(capacity));
+
+        REQUIRE(deque_create_flags(&q, sizeof(int), capacity, DEQUE_FLAG_EPOCH) == 0);
+
+        WHEN("容量を大きく超える回数、追加/取得を繰り返す") {
+
+            THEN("回収待ちのノードが再利用され、すべて追加/取得できること") {
+                for (int i = 0; i < 10000; ++i) {
+                    int buf = -1;
+                    REQUIRE(deque_push(&q, &i) == 0);
+                    REQUIRE(deque_shift(&q, &i) == 0);
+                    REQUIRE((deque_pop(&q, &buf)?:buf) == i);
+                    REQUIRE((deque_unshift(&q, &buf)?:buf) == i);
+                }
+                int buf;
+                CHECK(deque_pop(&q, &buf) == -1);
+                CHECK(deque_unshift(&q, &buf) == -1);
+            }
+        }
+
+        deque_destroy(&q);
+    }
+
+    GIVEN("両端キューをエポック指定で作成する") {
+        deq_t q;
+        size_t capacity{256};
+        static const int TEST_COUNT = 10000;
+
+        INFO("容量: " + std::to_string(capacity));
+
+        REQUIRE(deque_create_flags(&q, sizeof(int), capacity, DEQUE_FLAG_EPOCH) == 0);
+
+        WHEN("４つのスレッドから同時に両端へ追加/取得を繰り返す") {
+            std::atomic<long> pushed{0}, popped{0};
+            auto worker = [&](void *arg) -> void * {
+                intptr_t id = (intptr_t)arg;
+                for (int i = 0; i < TEST_COUNT; ++i) {
+                    int data = i, buf;
+                    int ret = (id % 2) ? deque_push(&q, &data) : deque_shift(&q, &data);
+                    if (ret != 0) {
+                        return (void *)(intptr_t)i;
+                    }
+                    pushed += data;
+                    while (((id / 2) ? deque_pop(&q, &buf) : deque_unshift(&q, &buf)) != 0) {
+                        sched_yield();
+                    }
+                    popped += buf;
+                    if ((i % 64) == 0) {
+                        sched_yield();
+                    }
+                }
+                return (void *)(intptr_t)TEST_COUNT;
+            };
+
+            pthread_t thr[4];
+            for (intptr_t t = 0; t < 4; ++t) {
+                REQUIRE(pthread_create(&thr[t], NULL, Lambda::ptr<void *, void *>(worker), (void *)t) == 0);
+            }
+
+            THEN("すべてのデータが 1 度ずつ取得できること") {
+                for (int t = 0; t < 4; ++t) {
+                    intptr_t count = 0;
+                    CHECK((pthread_join(thr[t], (void **)&count)?:count) == TEST_COUNT);
+                }
+                CHECK(pushed == popped);
+            }
+        }
+
+        deque_destroy(&q);
+    }
+}
+
 SCENARIO("両端キューへの並列アクセスが可能であること",
          tags("deque", "deque_push", "deque_shift", "deque_pop", "deque_unshift", "parallel")) {
 
@@ -453,7 +625,7 @@ SCENARIO("両端キューへの並列アクセスが可能であること",
             pthread_t pusher_thr1, pusher_thr2;
             struct param param_thr1 = {.count = TEST_COUNT, .offset = 0, pusher},
                          param_thr2 = {.count = TEST_COUNT, .offset = TEST_COUNT, pusher};
-            int count = 0;
+            intptr_t count = 0;
             REQUIRE(pthread_create(&pusher_thr1, NULL, Lambda::ptr<void *, void *>(worker), &param_thr1) == 0);
             REQUIRE(pthread_create(&pusher_thr2, NULL, Lambda::ptr<void *, void *>(worker), &param_thr2) == 0);
             REQUIRE((pthread_join(pusher_thr1, (void **)&count)?:count) == TEST_COUNT);
@@ -491,7 +663,7 @@ SCENARIO("両端キューへの並列アクセスが可能であること",
             pthread_t pusher_thr1, pusher_thr2;
             struct param param_thr1 = {.count = TEST_COUNT, .offset = 0, pusher},
                          param_thr2 = {.count = TEST_COUNT, .offset = TEST_COUNT, shifter};
-            int count = 0;
+            intptr_t count = 0;
             REQUIRE(pthread_create(&pusher_thr1, NULL, Lambda::ptr<void *, void *>(worker), &param_thr1) == 0);
             REQUIRE(pthread_create(&pusher_thr2, NULL, Lambda::ptr<void *, void *>(worker), &param_thr2) == 0);
             REQUIRE((pthread_join(pusher_thr1, (void **)&count)?:count) == TEST_COUNT);
@@ -545,7 +717,7 @@ SCENARIO("両端キューへの並列アクセスが可能であること",
             pthread_t pusher_thr1, shifter_thr2;
             struct param param_thr1 = {.count = TEST_COUNT, .offset = 0, pusher},
                          param_thr2 = {.count = TEST_COUNT, .offset = TEST_COUNT, shifter};
-            int count = 0;
+            intptr_t count = 0;
             REQUIRE(pthread_create(&pusher_thr1, NULL, Lambda::ptr<void *, void *>(worker), &param_thr1) == 0);
             REQUIRE(pthread_create(&shifter_thr2, NULL, Lambda::ptr<void *, void *>(worker), &param_thr2) == 0);
             msleep(10);
@@ -19,6 +19,7 @@
 
 #include "aux.h"
 #include "debug.h"
+#include "atomic.h"
 #include "mempool.h"
 
 /**
@@ -38,7 +39,7 @@ struct memory_fragment {
     (struct memory_fragment){   \
         .next = {               \
             .count = 0,         \
-            .frag = NULL,       \
+            .frag = 0,          \
         },                      \
     }
 
@@ -58,11 +59,11 @@ struct memory_fragment {
         .freeable = 0,             \
         .head = {                  \
             .count = 0,            \
-            .frag = NULL,          \
+            .frag = 0,             \
         },                         \
         .tail = {                  \
             .count = 0,            \
-            .frag = NULL,          \
+            .frag = 0,             \
         },                         \
     }
 
@@ -99,6 +100,62 @@ static inline bool memory_node_equals(struct memory_node a, struct memory_node b
         struct memory_node: memory_node_equals  \
     )(a, b)
 
+#if defined(MEMPOOL_IMPLEMENTED_INDEX)
+#define MEMORY_REF_NONE 0
+#define MEMPOOL_CAPACITY_MAX (UINT32_MAX - 1)
+#define node_load(p) atomic_load(p)
+#define node_store(p, v) atomic_store(p, v)
+#define node_cas(p, e, d) atomic_compare_exchange_weak(p, e, d)
+#else
+#define MEMORY_REF_NONE NULL
+#define MEMPOOL_CAPACITY_MAX (SIZE_MAX - 1)
+#define node_load(p) atomic_dw_load(p)
+#define node_store(p, v) atomic_dw_store(p, v)
+#define node_cas(p, e, d) atomic_dw_cas(p, e, d)
+#endif
+
+static inline size_t internal_mempool_aligned_data_bytes(struct memory_pool *self);
+
+/**
+ *  internal_mempool_frag desc.
+ *
+ *  @param  [in]    self    self desc.
+ *  @param  [in]    ref     ref desc.
+ *  @return Returns the fragment named by @c ref.
+ */
+static inline struct memory_fragment *internal_mempool_frag(struct memory_pool *self,
+                                                            memory_ref_t ref)
+{
+#if defined(MEMPOOL_IMPLEMENTED_INDEX)
+    size_t frag_bytes = internal_mempool_aligned_data_bytes(self);
+    return (struct memory_fragment *)((uintptr_t)self->pool
+                                      + (frag_bytes * (ref - 1)));
+#else
+    UNUSED_VARIABLE(self);
+    return ref;
+#endif
+}
+
+/**
+ *  internal_mempool_ref desc.
+ *
+ *  @param  [in]    self    self desc.
+ *  @param  [in]    frag    frag desc.
+ *  @return Returns the reference to @c frag.
+ */
+static inline memory_ref_t internal_mempool_ref(struct memory_pool *self,
+                                                struct memory_fragment *frag)
+{
+#if defined(MEMPOOL_IMPLEMENTED_INDEX)
+    size_t frag_bytes = internal_mempool_aligned_data_bytes(self);
+    return (memory_ref_t)(((uintptr_t)frag - (uintptr_t)self->pool)
+                          / frag_bytes + 1);
+#else
+    UNUSED_VARIABLE(self);
+    return frag;
+#endif
+}
+
 /**
  *  internal_mempool_put desc.
  *
@@ -109,37 +166,40 @@ static void internal_mempool_put(struct memory_pool *self, struct memory_fragmen
 {
 #if defined(MEMPOOL_IMPLEMENTED_QUEUE)
     *frag = MEMORY_FRAGMENT_MAKER();
+    memory_ref_t ref = internal_mempool_ref(self, frag);
 
     struct memory_node tail, tmp;
     while (true) {
-        tail = atomic_load(&self->tail);
-        struct memory_node next = tail.frag->next;
+        tail = node_load(&self->tail);
+        struct memory_fragment *last = internal_mempool_frag(self, tail.frag);
+        struct memory_node next = node_load(&last->next);
 
-        if (equals(tail, self->tail)) {
-            if (next.frag == NULL) {
-                tmp.frag = frag;
+        if (equals(tail, node_load(&self->tail))) {
+            if (next.frag == MEMORY_REF_NONE) {
+                tmp.frag = ref;
                 tmp.count = next.count + 1;
-                if (atomic_compare_exchange_weak(&tail.frag->next, &next, tmp)) {
+                if (node_cas(&last->next, &next, tmp)) {
                     break;
                 }
             } else {
                 tmp.frag = next.frag;
                 tmp.count = tail.count + 1;
-                atomic_compare_exchange_weak(&self->tail, &tail, tmp);
+                node_cas(&self->tail, &tail, tmp);
             }
         }
     }
-    tmp.frag = frag;
+    tmp.frag = ref;
     tmp.count = tail.count + 1;
-    atomic_compare_exchange_weak(&self->tail, &tail, tmp);
+    node_cas(&self->tail, &tail, tmp);
     atomic_fetch_add(&self->freeable, 1);
 #else
-    struct memory_node next, orig = atomic_load(&self->head);
+    memory_ref_t ref = internal_mempool_ref(self, frag);
+    struct memory_node next, orig = node_load(&self->head);
     do {
-        node->next.frag = orig.frag;
-        next.frag = frag;
+        frag->next.frag = orig.frag;
+        next.frag = ref;
         next.count = orig.count + 1;
-    } while (!atomic_compare_exchange_weak(&self->head, &orig, next));
+    } while (!node_cas(&self->head, &orig, next));
     atomic_fetch_add(&self->freeable, 1);
 #endif
 }
@@ -155,24 +215,25 @@ static struct memory_fragment *internal_mempool_pick(struct memory_pool *self)
 #if defined(MEMPOOL_IMPLEMENTED_QUEUE)
     struct memory_node head;
     while (true) {
-        head = atomic_load(&self->head);
-        struct memory_node tail = atomic_load(&self->tail),
-                           next = head.frag->next,
+        head = node_load(&self->head);
+        struct memory_fragment *first = internal_mempool_frag(self, head.frag);
+        struct memory_node tail = node_load(&self->tail),
+                           next = node_load(&first->next),
                            tmp;
 
-        if (equals(head, self->head)) {
+        if (equals(head, node_load(&self->head))) {
             if (head.frag == tail.frag) {
-                if (next.frag == NULL) {
+                if (next.frag == MEMORY_REF_NONE) {
                     errno = ENOMEM;
                     return NULL;
                 }
                 tmp.frag = next.frag;
                 tmp.count = tail.count + 1;
-                atomic_compare_exchange_weak(&self->tail, &tail, tmp);
+                node_cas(&self->tail, &tail, tmp);
             } else {
                 tmp.frag = next.frag;
                 tmp.count = head.count + 1;
-                if (atomic_compare_exchange_weak(&self->head, &head, tmp)) {
+                if (node_cas(&self->head, &head, tmp)) {
                     break;
                 }
             }
@@ -180,20 +241,20 @@ static struct memory_fragment *internal_mempool_pick(struct memory_pool *self)
     }
     atomic_fetch_sub(&self->freeable, 1);
 
-    return head.frag;
+    return internal_mempool_frag(self, head.frag);
 #else
-    struct memory_node next, orig = atomic_load(&self->head);
+    struct memory_node next, orig = node_load(&self->head);
     do {
-        if (orig.frag == NULL) {
+        if (orig.frag == MEMORY_REF_NONE) {
             errno = ENOMEM;
             return NULL;
         }
-        next.frag = orig.frag->next.frag;
+        next.frag = internal_mempool_frag(self, orig.frag)->next.frag;
         next.count = orig.count + 1;
-    } while (!atomic_compare_exchange_weak(&self->head, &orig, next));
+    } while (!node_cas(&self->head, &orig, next));
     atomic_fetch_sub(&self->freeable, 1);
 
-    return orig.frag;
+    return internal_mempool_frag(self, orig.frag);
 #endif
 }
 
@@ -205,7 +266,7 @@ static struct memory_fragment *internal_mempool_pick(struct memory_pool *self)
  */
 static inline size_t internal_mempool_aligned_data_bytes(struct memory_pool *self)
 {
-    size_t frag_bytes = max(self->data_bytes, sizeof(*self->head.frag));
+    size_t frag_bytes = max(self->data_bytes, sizeof(struct memory_fragment));
     /* Workarround: SEGV at atomic operations. */
     if (frag_bytes % 16) {
         frag_bytes += 16 - (frag_bytes % 16);
@@ -231,11 +292,11 @@ static void internal_mempool_setup(struct memory_pool *self,
 #if defined(MEMPOOL_IMPLEMENTED_QUEUE)
     struct memory_node node = {
         .count = 0,
-        .frag = (struct memory_fragment *)pool,
+        .frag = internal_mempool_ref(self, (struct memory_fragment *)pool),
     };
-    *node.frag = MEMORY_FRAGMENT_MAKER();
-    atomic_store(&self->head, node);
-    atomic_store(&self->tail, node);
+    *internal_mempool_frag(self, node.frag) = MEMORY_FRAGMENT_MAKER();
+    node_store(&self->head, node);
+    node_store(&self->tail, node);
 
     size_t frag_bytes = internal_mempool_aligned_data_bytes(self);
     struct memory_fragment *frag;
@@ -247,7 +308,7 @@ static void internal_mempool_setup(struct memory_pool *self,
     size_t frag_bytes = internal_mempool_aligned_data_bytes(self);
     for (size_t i = 0; i < self->capacity; ++i) {
         struct memory_fragment *frag = (struct memory_fragment *)((uintptr_t)pool + (frag_bytes * i));
-        *frag = MEMORY_MAKER();
+        *frag = MEMORY_FRAGMENT_MAKER();
         internal_mempool_put(self, frag);
     }
 #endif
@@ -263,7 +324,8 @@ static void internal_mempool_setup(struct memory_pool *self,
  */
 int mempool_create(mpool_t *mp, size_t data_bytes, size_t capacity)
 {
-    if ((mp == NULL) || (data_bytes == 0) || (capacity == 0)) {
+    if ((mp == NULL) || (data_bytes == 0) || (capacity == 0)
+        || (capacity > MEMPOOL_CAPACITY_MAX)) {
         errno = EINVAL;
         return -1;
     }
@@ -434,7 +496,7 @@ bool mempool_contains(mpool_t *mp, const void *ptr)
 
     size_t frag_bytes = internal_mempool_aligned_data_bytes(self);
 #if defined(MEMPOOL_IMPLEMENTED_QUEUE)
-    size_t pool_size = frag_bytes * self->capacity + 1;
+    size_t pool_size = frag_bytes * (self->capacity + 1);
 #else
     size_t pool_size = frag_bytes * self->capacity;
 #endif
@@ -18,26 +18,47 @@ extern "C" {
 
 #define MEMPOOL_IMPLEMENTED_QUEUE
 
+/*
+ *  Names fragments by a 32-bit index into the pool, so that a
+ *  memory_node (index + ABA count) is a single word updated with a plain
+ *  64-bit CAS. Comment out to name fragments by pointer with DWCAS.
+ */
+#define MEMPOOL_IMPLEMENTED_INDEX
+
 struct memory_fragment;
 
+#if defined(MEMPOOL_IMPLEMENTED_INDEX)
+typedef uint32_t memory_ref_t;                /**< 1-based index, 0 is none. */
+#else
+typedef struct memory_fragment *memory_ref_t; /**< fragment pointer. */
+#endif
+
 /**
  *  memory_node desc.
  */
 struct memory_node {
-    uint32_t count;               /**< count desc. */
-    struct memory_fragment *frag; /**< frag desc. */
+#if defined(MEMPOOL_IMPLEMENTED_INDEX)
+    alignas(8) uint32_t count;    /**< count desc. */
+#else
+    alignas(16) uintptr_t count;  /**< count desc. */
+#endif
+    memory_ref_t frag;            /**< frag desc. */
 };
 
 /**
  *  memory_pool desc.
  */
 typedef struct memory_pool {
-    void *pool;                                   /**< pool desc. */
+    /* read-only after creation. */
+    alignas(CACHE_LINE_BYTES) void *pool;         /**< pool desc. */
     size_t data_bytes;                            /**< data_bytes desc. */
     size_t capacity;                              /**< capacity desc. */
-    _Atomic(size_t) freeable;                     /**< freeable desc. */
-    alignas(16) _Atomic(struct memory_node) head; /**< head desc. */
-    alignas(16) _Atomic(struct memory_node) tail; /**< tail desc. */
+    /* taken from by mempool_alloc(). */
+    alignas(CACHE_LINE_BYTES) struct memory_node head;  /**< head desc. */
+    /* given back to by mempool_free(). */
+    alignas(CACHE_LINE_BYTES) struct memory_node tail;  /**< tail desc. */
+    /* counted by both. */
+    alignas(CACHE_LINE_BYTES) _Atomic(size_t) freeable; /**< freeable desc. */
 } mpool_t;
 
 /**
@@ -51,11 +72,11 @@ typedef struct memory_pool {
         .freeable = 0,          \
         .head = {               \
             .count = 0,         \
-            .frag = NULL,       \
+            .frag = 0,          \
         },                      \
         .tail = {               \
             .count = 0,         \
-            .frag = NULL,       \
+            .frag = 0,          \
         },                      \
     }
 
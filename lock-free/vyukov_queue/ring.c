@@ -0,0 +1,201 @@
+/** @file       ring.c
+ *  @brief      Bounded MPMC queue implementation.
+ *
+ *  Values live inline in an array of cache-line-sized slots. Each slot
+ *  carries a sequence number that says whose turn it is: a slot at
+ *  position @c pos is free for the enqueuer of @c pos while its sequence
+ *  is @c pos, and full for the dequeuer of @c pos once it is @c pos + 1.
+ *  The dequeuer hands it back for the next lap with @c pos + capacity.
+ *  Producers and consumers thus contend only on their own position
+ *  counter, with one CAS per operation.
+ *
+ *  @sa         [D.Vyukov,Bounded MPMC queue,1024cores]
+ *              (https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue)
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+
+#include "aux.h"
+#include "debug.h"
+#include "atomic.h"
+#include "ring.h"
+
+#define RING_CAPACITY_MAX ((SIZE_MAX >> 1) + 1)
+
+struct ring_slot {
+    size_t sequence;
+    alignas(8) uint8_t value[];
+};
+
+static inline size_t slot_byte_aligned(size_t value_bytes)
+{
+    size_t slot_bytes = sizeof(struct ring_slot) + value_bytes;
+    if (slot_bytes % CACHE_LINE_BYTES) {
+        slot_bytes += CACHE_LINE_BYTES - (slot_bytes % CACHE_LINE_BYTES);
+    }
+    return slot_bytes;
+}
+
+static inline struct ring_slot *slot_of(ring_t *self, size_t pos)
+{
+    return (struct ring_slot *)((uintptr_t)self->slots
+                                + (self->slot_bytes * (pos & self->mask)));
+}
+
+int ring_create(ring_t *r, size_t value_bytes, size_t capacity)
+{
+    if ((r == NULL) || (value_bytes == 0) || (capacity == 0)
+        || (capacity > RING_CAPACITY_MAX)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t n = 1;
+    while (n < capacity) {
+        n <<= 1;
+    }
+    size_t slot_bytes = slot_byte_aligned(value_bytes);
+    if (n > SIZE_MAX / slot_bytes) {
+        errno = EINVAL;
+        return -1;
+    }
+    void *slots = aligned_alloc(CACHE_LINE_BYTES, slot_bytes * n);
+    if (slots == NULL) {
+        return -1;
+    }
+
+    r->slots = slots;
+    r->mask = n - 1;
+    r->slot_bytes = slot_bytes;
+    r->value_bytes = value_bytes;
+    for (size_t i = 0; i < n; ++i) {
+        atomic_store_explicit(&slot_of(r, i)->sequence, i, memory_order_relaxed);
+    }
+    atomic_store(&r->enqueue_pos, 0);
+    atomic_store(&r->dequeue_pos, 0);
+
+    return 0;
+}
+
+int ring_destroy(ring_t *r)
+{
+    if (r == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    free(r->slots);
+    r->slots = NULL;
+
+    return 0;
+}
+
+size_t ring_capacity(ring_t *r)
+{
+    if (r == NULL) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    return r->mask + 1;
+}
+
+int ring_enqueue(ring_t *r, const void *value)
+{
+    if ((r == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct ring_slot *slot;
+    size_t pos = atomic_load_explicit(&r->enqueue_pos, memory_order_relaxed);
+    while (true) {
+        slot = slot_of(r, pos);
+        size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&r->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            errno = ENOMEM;     /* the dequeuer of the last lap is behind. */
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&r->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    memcpy(slot->value, value, r->value_bytes);
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+
+    return 0;
+}
+
+int ring_dequeue(ring_t *r, void *value)
+{
+    if ((r == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct ring_slot *slot;
+    size_t pos = atomic_load_explicit(&r->dequeue_pos, memory_order_relaxed);
+    while (true) {
+        slot = slot_of(r, pos);
+        size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&r->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (dif < 0) {
+            errno = ENOENT;     /* the enqueuer of this position is behind. */
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&r->dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    memcpy(value, slot->value, r->value_bytes);
+    atomic_store_explicit(&slot->sequence, pos + r->mask + 1, memory_order_release);
+
+    return 0;
+}
+
+void *ring_to_array(ring_t *r)
+{
+    if (r == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    size_t head = atomic_load(&r->dequeue_pos);
+    size_t n = atomic_load(&r->enqueue_pos) - head;
+    size_t size = r->value_bytes;
+    uint8_t *ptr = calloc(n, size);
+    if (ptr == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        memcpy(&ptr[size * i], slot_of(r, head + i)->value, size);
+    }
+
+    return ptr;
+}
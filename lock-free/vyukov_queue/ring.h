@@ -0,0 +1,48 @@
+/** @file       ring.h
+ *  @brief      Bounded MPMC queue implementation.
+ *
+ *  @sa         [D.Vyukov,Bounded MPMC queue,1024cores]
+ *              (https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue)
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#ifndef __ALGORITHMS_INTERNAL_RING_H__
+#define __ALGORITHMS_INTERNAL_RING_H__
+
+#include <stdalign.h>
+#include <stddef.h>
+
+#include "atomic.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef struct ring {
+    alignas(CACHE_LINE_BYTES) size_t enqueue_pos;
+    alignas(CACHE_LINE_BYTES) size_t dequeue_pos;
+    alignas(CACHE_LINE_BYTES) void *slots;
+    size_t mask;                /* capacity - 1, the capacity is a power of two. */
+    size_t slot_bytes;
+    size_t value_bytes;
+} ring_t;
+
+/* the capacity is rounded up to a power of two. */
+int ring_create(ring_t *r, size_t value_bytes, size_t capacity);
+int ring_destroy(ring_t *r);
+size_t ring_capacity(ring_t *r);
+/* fails with ENOMEM while full. */
+int ring_enqueue(ring_t *r, const void *value);
+/* fails with ENOENT while empty. */
+int ring_dequeue(ring_t *r, void *value);
+void *ring_to_array(ring_t *r);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __ALGORITHMS_INTERNAL_RING_H__ */
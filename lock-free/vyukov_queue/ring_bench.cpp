@@ -0,0 +1,97 @@
+/** @file       ring_bench.cpp
+ *  @brief      Benchmark for Bounded MPMC queue.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "ring.h"
+#include "queue.h"
+
+SCENARIO("キューの操作コストを計測する", tags(".", "benchmark", "ring_enqueue", "ring_dequeue")) {
+
+    GIVEN("キューを作成する") {
+        ring_t r;
+        queue_t q;
+
+        REQUIRE(ring_create(&r, sizeof(int), 1024) == 0);
+        REQUIRE(queue_create(&q, sizeof(int)) == 0);
+
+        BENCHMARK("ring enqueue / dequeue") {
+            int data = 10, buf;
+            ring_enqueue(&r, &data);
+            return ring_dequeue(&r, &buf);
+        };
+
+        BENCHMARK("michael-scott enqueue / dequeue") {
+            int data = 10, buf;
+            queue_enqueue(&q, &data);
+            return queue_dequeue(&q, &buf);
+        };
+
+        queue_destroy(&q);
+        ring_destroy(&r);
+    }
+}
+
+/**
+ *  Runs @c threads threads, each doing @c ops balanced enqueue/dequeue pairs.
+ */
+static void run_balanced(int threads, int ops,
+                         std::function<int(int *)> enqueue,
+                         std::function<int(int *)> dequeue)
+{
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([=] {
+            int data = t, buf;
+            for (int i = 0; i < ops; ++i) {
+                enqueue(&data);
+                dequeue(&buf);
+            }
+        });
+    }
+    for (auto &w: workers) {
+        w.join();
+    }
+}
+
+SCENARIO("リングと Michael-Scott キューをスレッド数ごとに比較する",
+         tags(".", "benchmark", "ring_create", "parallel")) {
+
+    static const int OPS = 10000;
+
+    GIVEN("キューを作成する") {
+        ring_t r;
+        queue_t q;
+
+        REQUIRE(ring_create(&r, sizeof(int), 1024) == 0);
+        REQUIRE(queue_create(&q, sizeof(int)) == 0);
+
+        for (int threads: {1, 2, 4, 8, 16}) {
+            BENCHMARK("ring " + std::to_string(threads) + " threads") {
+                run_balanced(threads, OPS,
+                             [&](int *v) { return ring_enqueue(&r, v); },
+                             [&](int *v) { return ring_dequeue(&r, v); });
+            };
+            BENCHMARK("michael-scott " + std::to_string(threads) + " threads") {
+                run_balanced(threads, OPS,
+                             [&](int *v) { return queue_enqueue(&q, v); },
+                             [&](int *v) { return queue_dequeue(&q, v); });
+            };
+        }
+
+        queue_destroy(&q);
+        ring_destroy(&r);
+    }
+}
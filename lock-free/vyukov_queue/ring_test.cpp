@@ -0,0 +1,240 @@
+/** @file       ring_test.cpp
+ *  @brief      Unit-test for Bounded MPMC queue.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <sched.h>
+#include <pthread.h>
+#include <catch2/catch.hpp>
+
+#include "utils.hpp"
+
+#include "ring.h"
+
+extern "C" {
+#include "debug.h"
+}
+
+SCENARIO("キューを作成できること", tags("ring", "ring_create", "ring_destroy")) {
+
+    GIVEN("特になし") {
+
+        WHEN("キューを作成する") {
+            ring_t r;
+
+            THEN("キューが作成できること") {
+                REQUIRE(ring_create(&r, sizeof(int), 16) == 0);
+                CHECK(ring_capacity(&r) == 16);
+                ring_destroy(&r);
+            }
+        }
+
+        WHEN("容量を 2 の冪以外で指定する") {
+            ring_t r;
+
+            THEN("容量が 2 の冪に切り上げられること") {
+                REQUIRE(ring_create(&r, sizeof(int), 100) == 0);
+                CHECK(ring_capacity(&r) == 128);
+                ring_destroy(&r);
+            }
+        }
+
+        WHEN("容量 0 でキューを作成する") {
+            ring_t r;
+
+            THEN("作成に失敗すること") {
+                CHECK(ring_create(&r, sizeof(int), 0) == -1);
+                CHECK(errno == EINVAL);
+            }
+        }
+    }
+}
+
+SCENARIO("キューにデータを追加できること", tags("ring", "ring_enqueue")) {
+
+    GIVEN("キューを作成する") {
+        ring_t r;
+
+        REQUIRE(ring_create(&r, sizeof(int), 4) == 0);
+
+        WHEN("キューに複数のデータを追加する") {
+            int data[]{10, 20, 30, 40};
+
+            INFO("データ: " + array_to_string(data));
+
+            THEN("データが追加できること") {
+                CHECK(ring_enqueue(&r, &data[0]) == 0);
+                CHECK(ring_enqueue(&r, &data[1]) == 0);
+                CHECK(ring_enqueue(&r, &data[2]) == 0);
+                CHECK(ring_enqueue(&r, &data[3]) == 0);
+
+                int *buf = (int *)ring_to_array(&r);
+                CHECK(buf != NULL);
+                if (buf != NULL) {
+                    CHECK(buf[0] == data[0]);
+                    CHECK(buf[1] == data[1]);
+                    CHECK(buf[2] == data[2]);
+                    CHECK(buf[3] == data[3]);
+                    free(buf);
+                }
+            }
+        }
+
+        WHEN("容量を超えてデータを追加する") {
+            int data[]{10, 20, 30, 40, 50};
+
+            THEN("容量を超えたデータは追加できないこと") {
+                CHECK(ring_enqueue(&r, &data[0]) == 0);
+                CHECK(ring_enqueue(&r, &data[1]) == 0);
+                CHECK(ring_enqueue(&r, &data[2]) == 0);
+                CHECK(ring_enqueue(&r, &data[3]) == 0);
+                CHECK(ring_enqueue(&r, &data[4]) == -1);
+                CHECK(errno == ENOMEM);
+            }
+        }
+
+        ring_destroy(&r);
+    }
+}
+
+SCENARIO("キューからデータを取得できること", tags("ring", "ring_dequeue")) {
+
+    GIVEN("キューを作成する") {
+        ring_t r;
+
+        REQUIRE(ring_create(&r, sizeof(int), 4) == 0);
+
+        WHEN("空のキューから取得する") {
+
+            THEN("取得に失敗すること") {
+                int buf;
+                CHECK(ring_dequeue(&r, &buf) == -1);
+                CHECK(errno == ENOENT);
+            }
+        }
+
+        WHEN("キューに複数のデータを追加する") {
+            int data[]{10, 20, 30, 40};
+            for (auto d: data) {
+                REQUIRE(ring_enqueue(&r, &d) == 0);
+            }
+
+            THEN("追加した順にデータが取得できること") {
+                int buf;
+                CHECK((ring_dequeue(&r, &buf)?:buf) == data[0]);
+                CHECK((ring_dequeue(&r, &buf)?:buf) == data[1]);
+                CHECK((ring_dequeue(&r, &buf)?:buf) == data[2]);
+                CHECK((ring_dequeue(&r, &buf)?:buf) == data[3]);
+                CHECK(ring_dequeue(&r, &buf) == -1);
+                CHECK(errno == ENOENT);
+            }
+        }
+
+        ring_destroy(&r);
+    }
+}
+
+SCENARIO("キューへのデータの追加/取得が繰り返しできること",
+         tags("ring", "ring_enqueue", "ring_dequeue", "reusable")) {
+
+    GIVEN("キューを作成する") {
+        ring_t r;
+
+        REQUIRE(ring_create(&r, sizeof(int), 4) == 0);
+
+        WHEN("容量を何周も超えて追加/取得を繰り返す") {
+
+            THEN("データが追加/取得できること") {
+                for (int i = 0; i < 100; i += 3) {
+                    int data, buf;
+                    CHECK((data = i, ring_enqueue(&r, &data)) == 0);
+                    CHECK((data = i + 1, ring_enqueue(&r, &data)) == 0);
+                    CHECK((data = i + 2, ring_enqueue(&r, &data)) == 0);
+                    CHECK((ring_dequeue(&r, &buf)?:buf) == i);
+                    CHECK((ring_dequeue(&r, &buf)?:buf) == i + 1);
+                    CHECK((ring_dequeue(&r, &buf)?:buf) == i + 2);
+                }
+            }
+        }
+
+        ring_destroy(&r);
+    }
+}
+
+SCENARIO("キューへの並列アクセスが可能であること",
+         tags("ring", "ring_enqueue", "ring_dequeue", "parallel")) {
+
+    GIVEN("容量の小さいキューを作成する") {
+        ring_t r;
+
+        REQUIRE(ring_create(&r, sizeof(int), 64) == 0);
+
+        struct param {
+            int count;
+            int offset;
+            std::function<int(int)> callback;
+        };
+        auto worker = [&](void *arg) -> void * {
+            struct param *prm = (struct param *)arg;
+            for (int i = 0; i < prm->count; ++i) {
+                if (prm->callback(prm->offset + i) != 0) {
+                    return (void *)(intptr_t)i;
+                }
+            }
+            return (void *)(intptr_t)prm->count;
+        };
+
+        WHEN("４つのスレッドから同時に追加/取得する") {
+            static const int TEST_COUNT = 10000;
+
+            auto pusher = [&](int data) -> int {
+                while (ring_enqueue(&r, &data) != 0) {
+                    sched_yield();
+                }
+                return 0;
+            };
+            BITFLAG bf = bitflag_create(TEST_COUNT * 2);
+            auto poper = [&](int) -> int {
+                int buf = -1;
+                while (ring_dequeue(&r, &buf) != 0) {
+                    sched_yield();
+                }
+                return bitflag_set(bf, buf);
+            };
+
+            pthread_t thr[4];
+            struct param prm[4] = {
+                {.count = TEST_COUNT, .offset = 0, .callback = pusher},
+                {.count = TEST_COUNT, .offset = TEST_COUNT, .callback = pusher},
+                {.count = TEST_COUNT, .offset = 0, .callback = poper},
+                {.count = TEST_COUNT, .offset = 0, .callback = poper},
+            };
+            for (int i = 0; i < 4; ++i) {
+                REQUIRE(pthread_create(&thr[i], NULL, Lambda::ptr<void *, void *>(worker), &prm[i]) == 0);
+            }
+
+            THEN("データが追加/取得できること") {
+                intptr_t count = 0;
+                for (int i = 0; i < 4; ++i) {
+                    REQUIRE((pthread_join(thr[i], (void **)&count)?:count) == TEST_COUNT);
+                }
+
+                bool is_all_set = true;
+                for (int i = 0; i < (TEST_COUNT * 2); ++i) {
+                    if (!bitflag_check(bf, i)) {
+                        is_all_set = false;
+                    }
+                }
+                CHECK(is_all_set == true);
+            }
+
+            bitflag_destroy(bf);
+        }
+
+        ring_destroy(&r);
+    }
+}
@@ -10,6 +10,7 @@
  *
  *  This code is licensed under the MIT License.
  */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -18,29 +19,133 @@
 #include <inttypes.h>
 #include <string.h>
 #include <errno.h>
+#include <stddef.h>
+#include <unistd.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 
 #include "aux.h"
 #include "debug.h"
 #include "atomic.h"
+#include "rseq.h"
+#include "eventcount.h"
 #include "stack.h"
 
-struct stack_node {
-    struct stack_node *next;
-    uint8_t value[];
+/**
+ *  Names nodes by a 32-bit index into node_buffer so that a head
+ *  (index + ABA tag) fits in a single word and is updated with a plain
+ *  64-bit CAS. Comment out to name nodes by pointer with a DWCAS head.
+ */
+#define STACK_IMPLEMENTED_INDEX
+
+#if defined(STACK_IMPLEMENTED_INDEX)
+typedef uint32_t stack_ref_t;   /* 1-based node index, 0 is none. */
+
+struct stack_head {
+    alignas(8) stack_ref_t node;
+    uint32_t aba;
 };
 
+#define STACK_REF_NONE 0
+#define STACK_CAPACITY_MAX UINT32_MAX
+#define head_load(h) atomic_load(h)
+#define head_cas(h, e, d) atomic_compare_exchange_weak(h, e, d)
+#else
+typedef struct stack_node *stack_ref_t;
+
 struct stack_head {
-    uintptr_t aba;
-    struct stack_node *node;
+    alignas(16) uintptr_t aba;
+    stack_ref_t node;
+};
+
+#define STACK_REF_NONE NULL
+#define STACK_CAPACITY_MAX SIZE_MAX
+#define head_load(h) atomic_dw_load(h)
+#define head_cas(h, e, d) atomic_dw_cas(h, e, d)
+#endif
+
+struct stack_node {
+    union {
+        stack_ref_t next;
+        struct stack_node *link;    /* next node on a per-CPU shard */
+    };
+    alignas(sizeof(void *)) uint8_t value[];
+};
+
+#define STACK_ELIMINATION_SLOTS 8
+#define STACK_ELIMINATION_SPINS 128
+
+/**
+ *  One rendezvous slot of the elimination array, on its own cache line.
+ *  A pusher parks its node in @c offer; a popper that swaps it out takes
+ *  the node over without touching the list head.
+ */
+struct stack_slot {
+    alignas(CACHE_LINE_BYTES) struct stack_head offer;
 };
 
+/**
+ *  Elimination array in front of one list, after Hendler, Shavit and
+ *  Yerushalmi. @c width is the adaptive number of slots in use: it grows
+ *  when threads collide on a slot and shrinks when offers time out.
+ */
+struct stack_exchanger {
+    alignas(CACHE_LINE_BYTES) _Atomic uint32_t width;
+    _Atomic size_t contend;     /* CASes left to fail, see stack_debug_contend(). */
+    _Atomic size_t widened;
+    _Atomic size_t narrowed;
+    _Atomic size_t eliminated;
+    struct stack_slot slots[STACK_ELIMINATION_SLOTS];
+};
+
+struct stack_elimination {
+    struct stack_exchanger head, free;
+};
+
+#define STACK_PERCPU_STEAL 16
+#define STACK_WAIT_SPINS 128
+
+enum {
+    STACK_SHARD_HEAD,
+    STACK_SHARD_FREE,
+    STACK_SHARD_LISTS,
+};
+
+/**
+ *  Per-CPU shard of a STACK_FLAG_PERCPU stack. Its lists are linked
+ *  through @c link and changed only by rseq critical sections on the
+ *  owning CPU, or by another thread while it holds @c fence.
+ */
+struct stack_shard {
+    alignas(CACHE_LINE_BYTES) intptr_t lists[STACK_SHARD_LISTS];
+    uint32_t fence;
+    _Atomic intptr_t size;  /* pushes minus pops counted here, may be negative. */
+};
+
+#define STACK_SEGMENTS_MAX 32
+
 struct stack {
-    size_t value_bytes;
+    /* read-mostly. */
+    alignas(CACHE_LINE_BYTES) size_t value_bytes;
     size_t node_bytes;
-    _Atomic size_t size;
-    alignas(16) _Atomic struct stack_head head, free;
-    alignas(16) void *node_buffer;
+    struct stack_elimination *elimination;
+    struct stack_shard *shards;
+    size_t nshards;
+    unsigned int flags;
+    size_t capacity;                        /* nodes in segment 0. */
+    _Atomic uint32_t segments;              /* segments in use. */
+    _Atomic bool shrinking;
+    void *_Atomic segment[STACK_SEGMENTS_MAX];  /* mapped on first use, never unmapped. */
+    struct eventcount ready;                /* stack_pop_wait() sleepers. */
+    /* pushed to by stack_push(), popped from by stack_pop(). */
+    alignas(CACHE_LINE_BYTES) struct stack_head head;
+    /* the other way round. */
+    alignas(CACHE_LINE_BYTES) struct stack_head free;
+    /* counted by both. */
+    alignas(CACHE_LINE_BYTES) _Atomic size_t size;
+    _Atomic size_t shrink_ticks;
+    _Atomic size_t stolen;                  /* head nodes taken from another shard. */
+    alignas(CACHE_LINE_BYTES) void *node_buffer;
 };
 
 static inline size_t node_byte_aligned(size_t value_bytes)
@@ -54,51 +159,739 @@ static inline size_t node_byte_aligned(size_t value_bytes)
     return node_bytes;
 }
 
-static struct stack_node *pop(_Atomic struct stack_head *head)
+/**
+ *  Bytes of a segment of @c nodes nodes. With STACK_FLAG_SOA a segment
+ *  is a dense array of next links followed by the packed values, so
+ *  walking a list never touches value cache lines.
+ */
+static inline size_t soa_values_offset(size_t nodes)
+{
+    static const size_t byte_aligned = 16;
+
+    size_t offset = sizeof(stack_ref_t) * nodes;
+    if (offset % byte_aligned) {
+        offset += byte_aligned - (offset % byte_aligned);
+    }
+    return offset;
+}
+
+static inline size_t layout_bytes(unsigned int flags, size_t value_bytes,
+                                  size_t node_bytes, size_t nodes)
+{
+    if (flags & STACK_FLAG_SOA) {
+        return soa_values_offset(nodes) + (value_bytes * nodes);
+    }
+    return node_bytes * nodes;
+}
+
+/**
+ *  Segment @c k holds capacity << k nodes, so that each new segment
+ *  doubles the total. Segment 0 is node_buffer.
+ */
+static inline size_t segment_nodes(struct stack *self, uint32_t k)
+{
+    return self->capacity << k;
+}
+
+/**
+ *  Number of nodes in segments [0, @c k).
+ */
+static inline size_t segment_first(struct stack *self, uint32_t k)
+{
+    return self->capacity * ((1UL << k) - 1);
+}
+
+static inline size_t segment_bytes(struct stack *self, uint32_t k)
+{
+    return layout_bytes(self->flags, self->value_bytes, self->node_bytes,
+                        segment_nodes(self, k));
+}
+
+static inline void *segment_base(struct stack *self, uint32_t k)
+{
+    return atomic_load_explicit(&self->segment[k], memory_order_relaxed);
+}
+
+#if defined(STACK_IMPLEMENTED_INDEX)
+/**
+ *  Finds the segment of @c ref and its position @c j in there.
+ */
+static inline uintptr_t segment_locate(struct stack *self, stack_ref_t ref,
+                                       uint32_t *k, size_t *j)
+{
+    size_t i = ref - 1;
+    if (i < self->capacity) {
+        *k = 0;
+        *j = i;
+        return (uintptr_t)&self->node_buffer;
+    }
+    *k = 63 - __builtin_clzl(i / self->capacity + 1);
+    *j = i - segment_first(self, *k);
+    return (uintptr_t)segment_base(self, *k);
+}
+#endif
+
+static inline struct stack_node *node_of(struct stack *self, stack_ref_t ref)
+{
+#if defined(STACK_IMPLEMENTED_INDEX)
+    uint32_t k;
+    size_t j;
+    uintptr_t base = segment_locate(self, ref, &k, &j);
+    return (struct stack_node *)(base + (self->node_bytes * j));
+#else
+    UNUSED_VARIABLE(self);
+    return ref;
+#endif
+}
+
+static inline stack_ref_t *next_of(struct stack *self, stack_ref_t ref)
+{
+#if defined(STACK_IMPLEMENTED_INDEX)
+    if (self->flags & STACK_FLAG_SOA) {
+        uint32_t k;
+        size_t j;
+        uintptr_t base = segment_locate(self, ref, &k, &j);
+        return (stack_ref_t *)base + j;
+    }
+#endif
+    return &node_of(self, ref)->next;
+}
+
+static inline uint8_t *value_of(struct stack *self, stack_ref_t ref)
+{
+#if defined(STACK_IMPLEMENTED_INDEX)
+    if (self->flags & STACK_FLAG_SOA) {
+        uint32_t k;
+        size_t j;
+        uintptr_t base = segment_locate(self, ref, &k, &j);
+        return (uint8_t *)(base + soa_values_offset(segment_nodes(self, k))
+                           + (self->value_bytes * j));
+    }
+#endif
+    return node_of(self, ref)->value;
+}
+
+static inline stack_ref_t ref_of(struct stack *self, uint32_t k, size_t i)
+{
+#if defined(STACK_IMPLEMENTED_INDEX)
+    return (stack_ref_t)(segment_first(self, k) + i + 1);
+#else
+    return (stack_ref_t)((uintptr_t)segment_base(self, k)
+                         + (self->node_bytes * i));
+#endif
+}
+
+/**
+ *  Inverse of value_of() for the values lent out by the zero-copy API.
+ */
+static inline stack_ref_t ref_of_value(struct stack *self, void *value)
+{
+#if defined(STACK_IMPLEMENTED_INDEX)
+    bool soa = (self->flags & STACK_FLAG_SOA);
+    uintptr_t addr = (uintptr_t)value;
+    for (uint32_t k = 0; k < STACK_SEGMENTS_MAX; ++k) {
+        uintptr_t base = (uintptr_t)segment_base(self, k);
+        if (base == 0) {
+            break;
+        }
+        size_t nodes = segment_nodes(self, k);
+        uintptr_t first = base + (soa ? soa_values_offset(nodes)
+                                      : offsetof(struct stack_node, value));
+        size_t stride = soa ? self->value_bytes : self->node_bytes;
+        if ((addr >= first) && (addr < first + (stride * nodes))) {
+            return ref_of(self, k, (addr - first) / stride);
+        }
+    }
+    return STACK_REF_NONE;
+#else
+    UNUSED_VARIABLE(self);
+    return (stack_ref_t)((uintptr_t)value - offsetof(struct stack_node, value));
+#endif
+}
+
+static inline struct stack_node *node_of_value(void *value)
+{
+    return (struct stack_node *)((uintptr_t)value - offsetof(struct stack_node, value));
+}
+
+static inline bool segment_contains(struct stack *self, uint32_t k, stack_ref_t ref)
+{
+#if defined(STACK_IMPLEMENTED_INDEX)
+    return (ref > segment_first(self, k)) && (ref <= segment_first(self, k + 1));
+#else
+    uintptr_t base = (uintptr_t)segment_base(self, k);
+    return ((uintptr_t)ref >= base)
+        && ((uintptr_t)ref < base + segment_bytes(self, k));
+#endif
+}
+
+static inline struct stack_slot *exchanger_slot(struct stack_exchanger *ex)
+{
+    static _Thread_local uint32_t seed;
+
+    uint32_t x = seed;
+    if (x == 0) {
+        x = (uint32_t)(uintptr_t)&seed | 1;
+    }
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    seed = x;
+
+    uint32_t width = atomic_load_explicit(&ex->width, memory_order_relaxed);
+    return &ex->slots[x % width];
+}
+
+static inline void exchanger_resize(struct stack_exchanger *ex, bool grow)
+{
+    uint32_t width = atomic_load_explicit(&ex->width, memory_order_relaxed);
+    if (grow && (width < STACK_ELIMINATION_SLOTS)) {
+        atomic_store_explicit(&ex->width, width * 2, memory_order_relaxed);
+        atomic_fetch_add_explicit(&ex->widened, 1, memory_order_relaxed);
+    } else if (!grow && (width > 1)) {
+        atomic_store_explicit(&ex->width, width / 2, memory_order_relaxed);
+        atomic_fetch_add_explicit(&ex->narrowed, 1, memory_order_relaxed);
+    }
+}
+
+/**
+ *  Consumes one of the CAS failures requested by stack_debug_contend().
+ *
+ *  @return Returns true if the caller should act as if its CAS failed.
+ */
+static inline bool exchanger_contended(struct stack_exchanger *ex)
 {
-    struct stack_head next, orig = atomic_load(head);
+    size_t n = atomic_load_explicit(&ex->contend, memory_order_relaxed);
+    while (n > 0) {
+        if ((n == SIZE_MAX)
+            || atomic_compare_exchange_weak_explicit(&ex->contend, &n, n - 1,
+                                                     memory_order_relaxed,
+                                                     memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ *  Offers @c ref to a concurrent exchanger_take().
+ *
+ *  @return Returns true if a popper took @c ref, false if it is still ours.
+ */
+static bool exchanger_give(struct stack_exchanger *ex, stack_ref_t ref)
+{
+    struct stack_slot *slot = exchanger_slot(ex);
+    struct stack_head orig = head_load(&slot->offer);
+    if (orig.node != STACK_REF_NONE) {
+        exchanger_resize(ex, true);
+        return false;
+    }
+    struct stack_head mine = {.node = ref, .aba = orig.aba + 1};
+    if (!head_cas(&slot->offer, &orig, mine)) {
+        exchanger_resize(ex, true);
+        return false;
+    }
+
+    for (int i = 0; i < STACK_ELIMINATION_SPINS; ++i) {
+        cpu_relax();
+        struct stack_head curr = head_load(&slot->offer);
+        if (curr.aba != mine.aba) {
+            return true;
+        }
+    }
+
+    struct stack_head empty = {.node = STACK_REF_NONE, .aba = mine.aba + 1};
+    if (head_cas(&slot->offer, &mine, empty)) {
+        exchanger_resize(ex, false);
+        return false;
+    }
+    return true;    /* taken while withdrawing */
+}
+
+/**
+ *  Takes a node offered by a concurrent exchanger_give().
+ *
+ *  @return Returns the node taken, STACK_REF_NONE if none was offered.
+ */
+static stack_ref_t exchanger_take(struct stack_exchanger *ex)
+{
+    struct stack_slot *slot = exchanger_slot(ex);
+    for (int i = 0; i < STACK_ELIMINATION_SPINS; ++i) {
+        struct stack_head orig = head_load(&slot->offer);
+        if (orig.node != STACK_REF_NONE) {
+            struct stack_head empty = {.node = STACK_REF_NONE, .aba = orig.aba + 1};
+            if (head_cas(&slot->offer, &orig, empty)) {
+                atomic_fetch_add_explicit(&ex->eliminated, 1, memory_order_relaxed);
+                return orig.node;
+            }
+            exchanger_resize(ex, true);
+            break;
+        }
+        cpu_relax();
+    }
+    return STACK_REF_NONE;
+}
+
+static stack_ref_t pop(struct stack *self, struct stack_head *head,
+                       struct stack_exchanger *ex)
+{
+    struct stack_head next, orig = head_load(head);
+    while (true) {
+        if (orig.node == STACK_REF_NONE) {
+            return STACK_REF_NONE;  /* empty stack */
+        }
+        next.aba = orig.aba + 1;
+        next.node = *next_of(self, orig.node);
+        if (((ex == NULL) || !exchanger_contended(ex)) && head_cas(head, &orig, next)) {
+            return orig.node;
+        }
+        if (ex != NULL) {
+            stack_ref_t ref = exchanger_take(ex);
+            if (ref != STACK_REF_NONE) {
+                return ref;
+            }
+            orig = head_load(head);
+        }
+    }
+}
+
+static void push(struct stack *self, struct stack_head *head,
+                 struct stack_exchanger *ex, stack_ref_t ref)
+{
+    stack_ref_t *link = next_of(self, ref);
+    struct stack_head next, orig = head_load(head);
+    while (true) {
+        *link = orig.node;
+        next.aba = orig.aba + 1;
+        next.node = ref;
+        if (((ex == NULL) || !exchanger_contended(ex)) && head_cas(head, &orig, next)) {
+            return;
+        }
+        if (ex != NULL) {
+            if (exchanger_give(ex, ref)) {
+                return;
+            }
+            orig = head_load(head);
+        }
+    }
+}
+
+/**
+ *  Detaches up to @c n nodes from the top of @c head with a single CAS.
+ *
+ *  The detached nodes stay linked through their @c next fields.
+ *
+ *  @return Returns the first node, STACK_REF_NONE if the list is empty.
+ */
+static stack_ref_t pop_chain(struct stack *self, struct stack_head *head,
+                             size_t n, size_t *count)
+{
+    struct stack_head next, orig = head_load(head);
+    size_t k;
     do {
-        if (orig.node == NULL) {
-            return NULL;    /* empty stack */
+        if (orig.node == STACK_REF_NONE) {
+            return STACK_REF_NONE;  /* empty stack */
+        }
+        stack_ref_t ref = *next_of(self, orig.node);
+        for (k = 1; (k < n) && (ref != STACK_REF_NONE); ++k) {
+            ref = *next_of(self, ref);
         }
         next.aba = orig.aba + 1;
-        next.node = orig.node->next;
-    } while (!atomic_compare_exchange_weak(head, &orig, next));
+        next.node = ref;
+    } while (!head_cas(head, &orig, next));
+    *count = k;
     return orig.node;
 }
 
-static void push(_Atomic struct stack_head *head, struct stack_node *node)
+/**
+ *  Splices the privately linked chain @c first .. @c last onto @c head
+ *  with a single CAS.
+ */
+static void push_chain(struct stack *self, struct stack_head *head,
+                       stack_ref_t first, stack_ref_t last)
 {
-    struct stack_head next, orig = atomic_load(head);
+    stack_ref_t *link = next_of(self, last);
+    struct stack_head next, orig = head_load(head);
     do {
-        node->next = orig.node;
+        *link = orig.node;
         next.aba = orig.aba + 1;
-        next.node = node;
-    } while (!atomic_compare_exchange_weak(head, &orig, next));
+        next.node = first;
+    } while (!head_cas(head, &orig, next));
+}
+
+static inline struct stack_exchanger *head_exchanger(struct stack *self)
+{
+    return (self->elimination != NULL) ? &self->elimination->head : NULL;
+}
+
+static inline struct stack_exchanger *free_exchanger(struct stack *self)
+{
+    return (self->elimination != NULL) ? &self->elimination->free : NULL;
+}
+
+/**
+ *  Takes shard @c i over from its CPU: once the fence is up and every
+ *  critical section running there has been restarted, none can commit.
+ */
+static void shard_lock(struct stack *self, size_t i)
+{
+    struct stack_shard *shard = &self->shards[i];
+    uint32_t unlocked = 0;
+    while (!__atomic_compare_exchange_n(&shard->fence, &unlocked, 1, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        unlocked = 0;
+        cpu_relax();
+    }
+    (void)rseq_fence_cpu((int)i);   /* fails only if the CPU is offline. */
+}
+
+static void shard_unlock(struct stack *self, size_t i)
+{
+    __atomic_store_n(&self->shards[i].fence, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ *  Also orders the plain commit store of a per-CPU push before the
+ *  waiter check in eventcount_notify(), being a seq_cst RMW.
+ */
+static inline void shard_count(struct stack *self, intptr_t n)
+{
+    size_t i = (size_t)rseq_current_cpu() % self->nshards;
+    atomic_fetch_add(&self->shards[i].size, n);
+}
+
+/**
+ *  Splices the privately linked chain @c first .. @c last onto @c list
+ *  of the calling CPU's shard.
+ */
+static void percpu_push_chain(struct stack *self, int list,
+                              struct stack_node *first, struct stack_node *last)
+{
+    while (true) {
+        int cpu = rseq_current_cpu();
+        if ((size_t)cpu >= self->nshards) {
+            /* CPU hot-added after stack_create(): borrow a shard. */
+            size_t i = (size_t)cpu % self->nshards;
+            shard_lock(self, i);
+            last->link = (struct stack_node *)self->shards[i].lists[list];
+            self->shards[i].lists[list] = (intptr_t)first;
+            shard_unlock(self, i);
+            return;
+        }
+
+        struct stack_shard *shard = &self->shards[cpu];
+        intptr_t orig = __atomic_load_n(&shard->lists[list], __ATOMIC_RELAXED);
+        last->link = (struct stack_node *)orig;
+        if (rseq_cmpeqv_storev(&shard->lists[list], orig, (intptr_t)first,
+                               cpu, &shard->fence) == 0) {
+            return;
+        }
+        cpu_relax();
+    }
+}
+
+/**
+ *  Takes up to STACK_PERCPU_STEAL nodes off @c list of the first
+ *  non-empty shard, starting at @c home, keeps one and moves the rest to
+ *  the calling CPU's shard.
+ *
+ *  @return Returns the node kept, NULL if every shard is empty.
+ */
+static struct stack_node *percpu_steal(struct stack *self, int list, size_t home)
+{
+    for (size_t k = 0; k < self->nshards; ++k) {
+        size_t i = (home + k) % self->nshards;
+        struct stack_shard *victim = &self->shards[i];
+        if (__atomic_load_n(&victim->lists[list], __ATOMIC_RELAXED) == 0) {
+            continue;
+        }
+
+        shard_lock(self, i);
+        struct stack_node *first = (struct stack_node *)victim->lists[list];
+        struct stack_node *last = first;
+        if (first != NULL) {
+            for (size_t n = 1; (n < STACK_PERCPU_STEAL) && (last->link != NULL); ++n) {
+                last = last->link;
+            }
+            victim->lists[list] = (intptr_t)last->link;
+        }
+        shard_unlock(self, i);
+
+        if (first != NULL) {
+            if ((list == STACK_SHARD_HEAD) && (i != home)) {
+                atomic_fetch_add_explicit(&self->stolen, 1, memory_order_relaxed);
+            }
+            if (first != last) {
+                percpu_push_chain(self, list, first->link, last);
+            }
+            return first;
+        }
+    }
+    return NULL;
+}
+
+/**
+ *  Pops one node off @c list of the calling CPU's shard, stealing from
+ *  the other shards when it is empty.
+ *
+ *  @return Returns the node, NULL if every shard is empty.
+ */
+static struct stack_node *percpu_pop(struct stack *self, int list)
+{
+    while (true) {
+        int cpu = rseq_current_cpu();
+        if ((size_t)cpu >= self->nshards) {
+            return percpu_steal(self, list, (size_t)cpu % self->nshards);
+        }
+
+        struct stack_shard *shard = &self->shards[cpu];
+        intptr_t node;
+        int ret = rseq_cmpnev_storeoffp_load(&shard->lists[list], 0,
+                                             offsetof(struct stack_node, link),
+                                             &node, cpu, &shard->fence);
+        if (ret == 0) {
+            return (struct stack_node *)node;
+        }
+        if (ret > 0) {
+            return percpu_steal(self, list, (size_t)cpu);
+        }
+        cpu_relax();    /* migrated, preempted or fenced: retry. */
+    }
+}
+
+/**
+ *  Appends the next segment and hands its nodes to the free list.
+ *
+ *  Segments are claimed by a CAS on @c segments, so concurrent growers
+ *  add one segment between them and the others simply retry their pop.
+ *
+ *  @return Returns true if the caller should retry, false if the stack
+ *          cannot grow.
+ */
+static bool stack_grow(struct stack *self)
+{
+    if (!(self->flags & STACK_FLAG_GROWABLE)) {
+        return false;
+    }
+    if (atomic_load(&self->shrinking)) {
+        cpu_relax();    /* the free list is detached for a moment. */
+        return true;
+    }
+
+    uint32_t k = atomic_load(&self->segments);
+    if ((k >= STACK_SEGMENTS_MAX)
+        || (segment_first(self, k + 1) > STACK_CAPACITY_MAX)
+        || (segment_nodes(self, k) > SIZE_MAX / self->node_bytes)) {
+        return false;
+    }
+    size_t nodes = segment_nodes(self, k);
+    size_t bytes = segment_bytes(self, k);
+
+    void *seg = segment_base(self, k);
+    if (seg == NULL) {
+        void *mine = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mine == MAP_FAILED) {
+            return false;
+        }
+        if (atomic_compare_exchange_strong(&self->segment[k], &seg, mine)) {
+            seg = mine;
+        } else {
+            munmap(mine, bytes);
+        }
+    }
+    if (!atomic_compare_exchange_strong(&self->segments, &k, k + 1)) {
+        return true;    /* grown or shrunk by another thread. */
+    }
+
+    if (self->shards != NULL) {
+        struct stack_node *first = node_of(self, ref_of(self, k, 0));
+        struct stack_node *last = node_of(self, ref_of(self, k, nodes - 1));
+        for (size_t i = 0; i < nodes - 1; ++i) {
+            node_of(self, ref_of(self, k, i))->link = node_of(self, ref_of(self, k, i + 1));
+        }
+        percpu_push_chain(self, STACK_SHARD_FREE, first, last);
+    } else {
+        for (size_t i = 0; i < nodes - 1; ++i) {
+            *next_of(self, ref_of(self, k, i)) = ref_of(self, k, i + 1);
+        }
+        push_chain(self, &self->free, ref_of(self, k, 0), ref_of(self, k, nodes - 1));
+    }
+    return true;
+}
+
+/**
+ *  Gives the last segment's memory back to the system once occupancy has
+ *  fallen below half of the segments under it.
+ *
+ *  The free list is detached briefly to check that every node of the
+ *  segment is free. The pages are dropped with MADV_DONTNEED rather than
+ *  unmapped: a popper still holding a stale node of the segment then
+ *  reads zeroes and fails its CAS on the ABA tag.
+ */
+static void stack_shrink(struct stack *self)
+{
+    uint32_t k = atomic_load(&self->segments) - 1;
+    if (k == 0) {
+        return;
+    }
+    size_t below = segment_first(self, k);
+    if (atomic_load(&self->size) * 2 >= below) {
+        return;
+    }
+    /* a failed attempt walked the free list; back off for as many pops. */
+    size_t ticks = atomic_load(&self->shrink_ticks);
+    if (ticks > 0) {
+        atomic_compare_exchange_weak(&self->shrink_ticks, &ticks, ticks - 1);
+        return;
+    }
+    if (atomic_exchange(&self->shrinking, true)) {
+        return;
+    }
+
+    struct stack_head next, orig = head_load(&self->free);
+    do {
+        next.aba = orig.aba + 1;
+        next.node = STACK_REF_NONE;
+    } while (!head_cas(&self->free, &orig, next));
+
+    stack_ref_t kept = STACK_REF_NONE, kept_last = STACK_REF_NONE;
+    stack_ref_t victims = STACK_REF_NONE, victims_last = STACK_REF_NONE;
+    size_t count = 0;
+    stack_ref_t ref = orig.node;
+    while (ref != STACK_REF_NONE) {
+        stack_ref_t *link = next_of(self, ref);
+        stack_ref_t succ = *link;
+        if (segment_contains(self, k, ref)) {
+            *link = victims;
+            victims = ref;
+            if (victims_last == STACK_REF_NONE) {
+                victims_last = ref;
+            }
+            ++count;
+        } else {
+            *link = kept;
+            kept = ref;
+            if (kept_last == STACK_REF_NONE) {
+                kept_last = ref;
+            }
+        }
+        ref = succ;
+    }
+
+    bool released = false;
+    if (count == segment_nodes(self, k)) {
+        /* drop the pages first: once published, a grower may relink them. */
+        madvise(segment_base(self, k), segment_bytes(self, k), MADV_DONTNEED);
+        uint32_t segments = k + 1;
+        released = atomic_compare_exchange_strong(&self->segments, &segments, k);
+        if (!released) {
+            for (size_t i = 0; i < count - 1; ++i) {
+                *next_of(self, ref_of(self, k, i)) = ref_of(self, k, i + 1);
+            }
+            victims = ref_of(self, k, 0);
+            victims_last = ref_of(self, k, count - 1);
+        }
+    }
+    if (!released) {
+        atomic_store(&self->shrink_ticks, below);
+    }
+    if (!released && (victims != STACK_REF_NONE)) {
+        *next_of(self, victims_last) = kept;
+        kept = victims;
+        if (kept_last == STACK_REF_NONE) {
+            kept_last = victims_last;
+        }
+    }
+    if (kept != STACK_REF_NONE) {
+        push_chain(self, &self->free, kept, kept_last);
+    }
+
+    atomic_store(&self->shrinking, false);
 }
 
 stack_t stack_create(size_t value_bytes, size_t capacity)
 {
+    return stack_create_flags(value_bytes, capacity, 0);
+}
+
+stack_t stack_create_flags(size_t value_bytes, size_t capacity, unsigned int flags)
+{
+    if ((capacity == 0) || (capacity > STACK_CAPACITY_MAX)) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+#if defined(STACK_IMPLEMENTED_INDEX)
+    if ((flags & STACK_FLAG_SOA) && (flags & STACK_FLAG_PERCPU)) {
+#else
+    if (flags & STACK_FLAG_SOA) {
+#endif
+        errno = EINVAL;
+        return NULL;
+    }
+
     size_t node_bytes = node_byte_aligned(value_bytes);
-    struct stack *self = calloc(1, sizeof(*self) + (node_bytes * capacity));
+    size_t bytes = sizeof(struct stack) + layout_bytes(flags, value_bytes, node_bytes, capacity);
+    if (bytes % alignof(struct stack)) {
+        bytes += alignof(struct stack) - (bytes % alignof(struct stack));
+    }
+    struct stack *self = aligned_alloc(alignof(struct stack), bytes);
     if (self == NULL) {
         return NULL;
     }
+    memset(self, 0, bytes);
+    if (flags & STACK_FLAG_SHRINKABLE) {
+        flags |= STACK_FLAG_GROWABLE;
+    }
+    if (flags & STACK_FLAG_PERCPU) {
+        flags &= ~STACK_FLAG_SHRINKABLE;
+    }
     self->value_bytes = value_bytes;
     self->node_bytes = node_bytes;
-    atomic_store(&self->head, ((struct stack_head){0, NULL}));
+    self->flags = flags;
+    self->capacity = capacity;
+    atomic_store(&self->segments, 1);
+    atomic_store(&self->segment[0], (void *)&self->node_buffer);
+    self->head = (struct stack_head){.aba = 0, .node = STACK_REF_NONE};
     atomic_store(&self->size, 0);
+    eventcount_init(&self->ready);
 
     for (size_t i = 0; i < capacity - 1; ++i) {
-        struct stack_node *node =
-            (struct stack_node *)((uintptr_t)&self->node_buffer
-                                  + (node_bytes * i));
-        struct stack_node *next =
-            (struct stack_node *)((uintptr_t)&self->node_buffer
-                                  + (node_bytes * (i + 1)));
-        node->next = next;
+        *next_of(self, ref_of(self, 0, i)) = ref_of(self, 0, i + 1);
+    }
+    self->free = (struct stack_head){.aba = 0, .node = ref_of(self, 0, 0)};
+
+    if ((flags & STACK_FLAG_PERCPU) && rseq_available()) {
+        long nprocs = sysconf(_SC_NPROCESSORS_CONF);
+        self->nshards = (nprocs > 0) ? (size_t)nprocs : 1;
+        self->shards = aligned_alloc(alignof(struct stack_shard),
+                                     sizeof(*self->shards) * self->nshards);
+        if (self->shards == NULL) {
+            free(self);
+            return NULL;
+        }
+        memset(self->shards, 0, sizeof(*self->shards) * self->nshards);
+
+        /* deal the free nodes out to the shards. */
+        for (size_t i = 0; i < capacity; ++i) {
+            struct stack_shard *shard = &self->shards[i % self->nshards];
+            struct stack_node *node = node_of(self, ref_of(self, 0, i));
+            node->link = (struct stack_node *)shard->lists[STACK_SHARD_FREE];
+            shard->lists[STACK_SHARD_FREE] = (intptr_t)node;
+        }
+        self->free = (struct stack_head){.aba = 0, .node = STACK_REF_NONE};
+    } else if (flags & STACK_FLAG_ELIMINATION) {
+        self->elimination = aligned_alloc(alignof(struct stack_elimination),
+                                          sizeof(*self->elimination));
+        if (self->elimination == NULL) {
+            free(self);
+            return NULL;
+        }
+        memset(self->elimination, 0, sizeof(*self->elimination));
+        atomic_store(&self->elimination->head.width, 1);
+        atomic_store(&self->elimination->free.width, 1);
     }
-    atomic_store(&self->free, ((struct stack_head){0, (struct stack_node *)&self->node_buffer}));
 
     return (stack_t)self;
 }
@@ -106,6 +899,14 @@ stack_t stack_create(size_t value_bytes, size_t capacity)
 int stack_destroy(stack_t s)
 {
     struct stack *self = (struct stack *)s;
+    for (uint32_t k = 1; k < STACK_SEGMENTS_MAX; ++k) {
+        void *seg = segment_base(self, k);
+        if (seg != NULL) {
+            munmap(seg, segment_bytes(self, k));
+        }
+    }
+    free(self->shards);
+    free(self->elimination);
     free(self);
     return 0;
 }
@@ -118,9 +919,68 @@ size_t stack_size(stack_t s)
     }
 
     struct stack *self = (struct stack *)s;
+    if (self->shards != NULL) {
+        intptr_t size = 0;
+        for (size_t i = 0; i < self->nshards; ++i) {
+            size += atomic_load_explicit(&self->shards[i].size, memory_order_relaxed);
+        }
+        return (size > 0) ? (size_t)size : 0;
+    }
     return atomic_load(&self->size);
 }
 
+int stack_get_stats(stack_t s, struct stack_stats *stats)
+{
+    if ((s == NULL) || (stats == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct stack *self = (struct stack *)s;
+    memset(stats, 0, sizeof(*stats));
+    stats->flags = self->flags;
+    if (self->shards == NULL) {
+        stats->flags &= ~STACK_FLAG_PERCPU;
+    }
+    stats->nshards = self->nshards;
+    stats->stolen = atomic_load_explicit(&self->stolen, memory_order_relaxed);
+    struct stack_exchanger *ex = head_exchanger(self);
+    if (ex != NULL) {
+        stats->width = atomic_load_explicit(&ex->width, memory_order_relaxed);
+        stats->widened = atomic_load_explicit(&ex->widened, memory_order_relaxed);
+        stats->narrowed = atomic_load_explicit(&ex->narrowed, memory_order_relaxed);
+        stats->eliminated = atomic_load_explicit(&ex->eliminated, memory_order_relaxed);
+    }
+    return 0;
+}
+
+int stack_debug_contend(stack_t s, size_t n)
+{
+    if (s == NULL) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct stack_exchanger *ex = head_exchanger((struct stack *)s);
+    if (ex == NULL) {
+        errno = ENOTSUP;
+        return -1;
+    }
+    atomic_store(&ex->contend, n);
+    return 0;
+}
+
+size_t stack_capacity(stack_t s)
+{
+    if (s == NULL) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    struct stack *self = (struct stack *)s;
+    return segment_first(self, atomic_load(&self->segments));
+}
+
 int stack_push(stack_t s, void *value)
 {
     if ((s == NULL) || (value == NULL)) {
@@ -129,14 +989,32 @@ int stack_push(stack_t s, void *value)
     }
 
     struct stack *self = (struct stack *)s;
-    struct stack_node *node = pop(&self->free);
-    if (node == NULL) {
-        errno = ENOMEM;
-        return -1;
+    if (self->shards != NULL) {
+        struct stack_node *node;
+        while ((node = percpu_pop(self, STACK_SHARD_FREE)) == NULL) {
+            if (!stack_grow(self)) {
+                errno = ENOMEM;
+                return -1;
+            }
+        }
+        memcpy(node->value, value, self->value_bytes);
+        percpu_push_chain(self, STACK_SHARD_HEAD, node, node);
+        shard_count(self, 1);
+        eventcount_notify(&self->ready);
+        return 0;
+    }
+
+    stack_ref_t ref;
+    while ((ref = pop(self, &self->free, free_exchanger(self))) == STACK_REF_NONE) {
+        if (!stack_grow(self)) {
+            errno = ENOMEM;
+            return -1;
+        }
     }
-    memcpy(node->value, value, self->value_bytes);
-    push(&self->head, node);
+    memcpy(value_of(self, ref), value, self->value_bytes);
+    push(self, &self->head, head_exchanger(self), ref);
     atomic_inc(&self->size);
+    eventcount_notify(&self->ready);
 
     return 0;
 }
@@ -149,14 +1027,311 @@ int stack_pop(stack_t s, void *value)
     }
 
     struct stack *self = (struct stack *)s;
-    struct stack_node *node = pop(&self->head);
-    if (node == NULL) {
+    if (self->shards != NULL) {
+        struct stack_node *node = percpu_pop(self, STACK_SHARD_HEAD);
+        if (node == NULL) {
+            errno = ENOMEM;
+            return -1;
+        }
+        shard_count(self, -1);
+        memcpy(value, node->value, self->value_bytes);
+        percpu_push_chain(self, STACK_SHARD_FREE, node, node);
+        return 0;
+    }
+
+    stack_ref_t ref = pop(self, &self->head, head_exchanger(self));
+    if (ref == STACK_REF_NONE) {
+        errno = ENOMEM;
+        return -1;
+    }
+    atomic_dec(&self->size);
+    memcpy(value, value_of(self, ref), self->value_bytes);
+    push(self, &self->free, free_exchanger(self), ref);
+    if (self->flags & STACK_FLAG_SHRINKABLE) {
+        stack_shrink(self);
+    }
+
+    return 0;
+}
+
+ssize_t stack_push_n(stack_t s, const void *values, size_t n)
+{
+    if ((s == NULL) || (values == NULL) || (n == 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct stack *self = (struct stack *)s;
+    size_t count;
+    if (self->shards != NULL) {
+        /* shards are LIFO per CPU only, so a chain buys nothing here. */
+        const uint8_t *src = (const uint8_t *)values;
+        for (count = 0; count < n; ++count) {
+            if (stack_push(s, (void *)src) != 0) {
+                break;
+            }
+            src += self->value_bytes;
+        }
+        return (count > 0) ? (ssize_t)count : -1;
+    }
+
+    stack_ref_t first;
+    while ((first = pop_chain(self, &self->free, n, &count)) == STACK_REF_NONE) {
+        if (!stack_grow(self)) {
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+
+    /* the first node becomes the top, so it takes the last value. */
+    const uint8_t *src = (const uint8_t *)values + (self->value_bytes * count);
+    stack_ref_t ref = first, last = first;
+    for (size_t i = 0; i < count; ++i) {
+        src -= self->value_bytes;
+        memcpy(value_of(self, ref), src, self->value_bytes);
+        last = ref;
+        ref = *next_of(self, ref);
+    }
+    push_chain(self, &self->head, first, last);
+    atomic_fetch_add(&self->size, count);
+    eventcount_notify(&self->ready);
+
+    return (ssize_t)count;
+}
+
+ssize_t stack_pop_n(stack_t s, void *values, size_t n)
+{
+    if ((s == NULL) || (values == NULL) || (n == 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct stack *self = (struct stack *)s;
+    size_t count;
+    if (self->shards != NULL) {
+        uint8_t *dst = (uint8_t *)values;
+        for (count = 0; count < n; ++count) {
+            if (stack_pop(s, dst) != 0) {
+                break;
+            }
+            dst += self->value_bytes;
+        }
+        return (count > 0) ? (ssize_t)count : -1;
+    }
+
+    stack_ref_t first = pop_chain(self, &self->head, n, &count);
+    if (first == STACK_REF_NONE) {
         errno = ENOMEM;
         return -1;
     }
+    atomic_fetch_sub(&self->size, count);
+
+    uint8_t *dst = (uint8_t *)values;
+    stack_ref_t ref = first, last = first;
+    for (size_t i = 0; i < count; ++i) {
+        memcpy(dst, value_of(self, ref), self->value_bytes);
+        dst += self->value_bytes;
+        last = ref;
+        ref = *next_of(self, ref);
+    }
+    push_chain(self, &self->free, first, last);
+    if (self->flags & STACK_FLAG_SHRINKABLE) {
+        stack_shrink(self);
+    }
+
+    return (ssize_t)count;
+}
+
+ssize_t stack_pop_all(stack_t s, void (*drain)(void *value, void *arg), void *arg)
+{
+    if ((s == NULL) || (drain == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct stack *self = (struct stack *)s;
+    if (self->shards != NULL) {
+        size_t count = 0;
+        struct stack_node *node;
+        while ((node = percpu_pop(self, STACK_SHARD_HEAD)) != NULL) {
+            shard_count(self, -1);
+            drain(node->value, arg);
+            percpu_push_chain(self, STACK_SHARD_FREE, node, node);
+            ++count;
+        }
+        if (count == 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+        return (ssize_t)count;
+    }
+
+    struct stack_head next, orig = head_load(&self->head);
+    do {
+        if (orig.node == STACK_REF_NONE) {
+            errno = ENOMEM;
+            return -1;
+        }
+        next.aba = orig.aba + 1;
+        next.node = STACK_REF_NONE;
+    } while (!head_cas(&self->head, &orig, next));
+
+    size_t count = 0;
+    stack_ref_t ref = orig.node, last = orig.node;
+    while (ref != STACK_REF_NONE) {
+        drain(value_of(self, ref), arg);
+        last = ref;
+        ref = *next_of(self, ref);
+        ++count;
+    }
+    atomic_fetch_sub(&self->size, count);
+    push_chain(self, &self->free, orig.node, last);
+    if (self->flags & STACK_FLAG_SHRINKABLE) {
+        stack_shrink(self);
+    }
+
+    return (ssize_t)count;
+}
+
+int stack_pop_wait(stack_t s, void *value, int timeout_ms)
+{
+    if ((s == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct stack *self = (struct stack *)s;
+    for (int i = 0; i < STACK_WAIT_SPINS; ++i) {
+        if (stack_pop(s, value) == 0) {
+            return 0;
+        }
+        cpu_relax();
+    }
+
+    struct timespec ts, *deadline = eventcount_deadline(timeout_ms, &ts);
+    while (true) {
+        uint32_t key = eventcount_prepare(&self->ready);
+        if (stack_pop(s, value) == 0) {
+            eventcount_cancel(&self->ready);
+            return 0;
+        }
+        if (eventcount_wait(&self->ready, key, deadline) != 0) {
+            if (stack_pop(s, value) == 0) {
+                return 0;
+            }
+            errno = ETIMEDOUT;
+            return -1;
+        }
+    }
+}
+
+void *stack_push_reserve(stack_t s)
+{
+    if (s == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    struct stack *self = (struct stack *)s;
+    if (self->shards != NULL) {
+        struct stack_node *node;
+        while ((node = percpu_pop(self, STACK_SHARD_FREE)) == NULL) {
+            if (!stack_grow(self)) {
+                errno = ENOMEM;
+                return NULL;
+            }
+        }
+        return node->value;
+    }
+
+    stack_ref_t ref;
+    while ((ref = pop(self, &self->free, free_exchanger(self))) == STACK_REF_NONE) {
+        if (!stack_grow(self)) {
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+    return value_of(self, ref);
+}
+
+int stack_push_commit(stack_t s, void *value)
+{
+    if ((s == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct stack *self = (struct stack *)s;
+    if (self->shards != NULL) {
+        struct stack_node *node = node_of_value(value);
+        percpu_push_chain(self, STACK_SHARD_HEAD, node, node);
+        shard_count(self, 1);
+        eventcount_notify(&self->ready);
+        return 0;
+    }
+
+    stack_ref_t ref = ref_of_value(self, value);
+    if (ref == STACK_REF_NONE) {
+        errno = EINVAL;
+        return -1;
+    }
+    push(self, &self->head, head_exchanger(self), ref);
+    atomic_inc(&self->size);
+    eventcount_notify(&self->ready);
+
+    return 0;
+}
+
+void *stack_pop_acquire(stack_t s)
+{
+    if (s == NULL) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    struct stack *self = (struct stack *)s;
+    if (self->shards != NULL) {
+        struct stack_node *node = percpu_pop(self, STACK_SHARD_HEAD);
+        if (node == NULL) {
+            errno = ENOMEM;
+            return NULL;
+        }
+        shard_count(self, -1);
+        return node->value;
+    }
+
+    stack_ref_t ref = pop(self, &self->head, head_exchanger(self));
+    if (ref == STACK_REF_NONE) {
+        errno = ENOMEM;
+        return NULL;
+    }
     atomic_dec(&self->size);
-    memcpy(value, node->value, self->value_bytes);
-    push(&self->free, node);
+    return value_of(self, ref);
+}
+
+int stack_pop_release(stack_t s, void *value)
+{
+    if ((s == NULL) || (value == NULL)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct stack *self = (struct stack *)s;
+    if (self->shards != NULL) {
+        struct stack_node *node = node_of_value(value);
+        percpu_push_chain(self, STACK_SHARD_FREE, node, node);
+        return 0;
+    }
+
+    stack_ref_t ref = ref_of_value(self, value);
+    if (ref == STACK_REF_NONE) {
+        errno = EINVAL;
+        return -1;
+    }
+    push(self, &self->free, free_exchanger(self), ref);
+    if (self->flags & STACK_FLAG_SHRINKABLE) {
+        stack_shrink(self);
+    }
 
     return 0;
 }
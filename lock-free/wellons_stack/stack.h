@@ -19,11 +19,53 @@ extern "C" {
 
 typedef struct {} *stack_t;
 
+/* Flags for stack_create_flags(). */
+#define STACK_FLAG_ELIMINATION (1U << 0) /* elimination-backoff on contention */
+#define STACK_FLAG_PERCPU      (1U << 1) /* per-CPU rseq shards, LIFO per CPU only */
+#define STACK_FLAG_GROWABLE    (1U << 2) /* add doubling segments instead of ENOMEM */
+#define STACK_FLAG_SHRINKABLE  (1U << 3) /* growable, and release idle segments */
+#define STACK_FLAG_SOA         (1U << 4) /* next[] and packed value[] arrays, index mode only */
+
 stack_t stack_create(size_t value_bytes, size_t capacity);
+stack_t stack_create_flags(size_t value_bytes, size_t capacity, unsigned int flags);
 int stack_destroy(stack_t s);
 size_t stack_size(stack_t s);
+size_t stack_capacity(stack_t s);
 int stack_push(stack_t s, void *value);
 int stack_pop(stack_t s, void *value);
+ssize_t stack_push_n(stack_t s, const void *values, size_t n);
+ssize_t stack_pop_n(stack_t s, void *values, size_t n);
+ssize_t stack_pop_all(stack_t s, void (*drain)(void *value, void *arg), void *arg);
+/* stack_pop() that sleeps while empty, up to timeout_ms (-1: forever). */
+int stack_pop_wait(stack_t s, void *value, int timeout_ms);
+
+/*
+ *  Zero-copy access: stack_push_reserve() lends out a free node's value
+ *  to be built in place and stack_push_commit() publishes it;
+ *  stack_pop_acquire() lends out the top value until stack_pop_release()
+ *  frees it. Releasing a reserved value drops the reservation.
+ *  With STACK_FLAG_SOA values are packed at value_bytes stride, so they
+ *  are only as aligned as value_bytes allows.
+ */
+void *stack_push_reserve(stack_t s);
+int stack_push_commit(stack_t s, void *value);
+void *stack_pop_acquire(stack_t s);
+int stack_pop_release(stack_t s, void *value);
+
+/* Counters of the list head's elimination array and shards, for tests and tuning. */
+struct stack_stats {
+    unsigned int flags;     /* flags in effect, no STACK_FLAG_PERCPU without rseq */
+    size_t nshards;         /* per-CPU shards, 0 without STACK_FLAG_PERCPU */
+    size_t stolen;          /* pops served from another CPU's shard */
+    size_t width;           /* slots in use, 0 without STACK_FLAG_ELIMINATION */
+    size_t widened;         /* width doublings on collisions */
+    size_t narrowed;        /* width halvings on timed-out offers */
+    size_t eliminated;      /* pushes handed straight to a pop */
+};
+
+int stack_get_stats(stack_t s, struct stack_stats *stats);
+/* Fails the next n list head CASes of push/pop as if contended (SIZE_MAX: until reset). */
+int stack_debug_contend(stack_t s, size_t n);
 
 #if defined(__cplusplus)
 }
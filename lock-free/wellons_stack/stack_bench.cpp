@@ -0,0 +1,214 @@
+/** @file       stack_bench.cpp
+ *  @brief      Benchmark for Stack.
+ *
+ *  @author     t-kenji <protect.2501@gmail.com>
+ *  @date       2026-10-16 create new.
+ *  @copyright  Copyright (c) 2026 t-kenji
+ *
+ *  This code is licensed under the MIT License.
+ */
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <malloc.h>
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+
+#include "utils.hpp"
+
+#include "atomic.h"
+#include "stack.h"
+
+SCENARIO("ダブルワード CAS のコストを計測する", tags(".", "benchmark", "atomic")) {
+
+    struct pair {
+        uintptr_t aba;
+        void *node;
+    };
+
+    GIVEN("libatomic (std::atomic) 経由の場合") {
+        alignas(16) std::atomic<struct pair> head{{0, nullptr}};
+
+        INFO("lock-free: " + std::to_string(head.is_lock_free()));
+
+        BENCHMARK("load") {
+            return head.load();
+        };
+        BENCHMARK("compare_exchange") {
+            struct pair orig = head.load();
+            return head.compare_exchange_weak(orig, {orig.aba + 1, nullptr});
+        };
+    }
+
+    GIVEN("atomic.h (cmpxchg16b) 経由の場合") {
+        atomic_dw_t head{0, 0};
+
+        INFO("features: " + std::to_string(atomic_dw_features()));
+
+        BENCHMARK("load") {
+            atomic_dw_t orig;
+            internal_atomic_dw_load(&head, &orig);
+            return orig;
+        };
+        BENCHMARK("compare_exchange") {
+            atomic_dw_t orig, next;
+            internal_atomic_dw_load(&head, &orig);
+            next = {orig.lo + 1, 0};
+            return internal_atomic_dw_cas(&head, &orig, &next);
+        };
+    }
+}
+
+SCENARIO("スタックの操作コストを計測する", tags(".", "benchmark", "stack_push", "stack_pop")) {
+
+    GIVEN("スタックを作成する") {
+        stack_t s;
+        size_t capacity{1024};
+
+        REQUIRE((s = stack_create(sizeof(int), capacity)) != NULL);
+
+        BENCHMARK("push / pop") {
+            int data = 10, buf;
+            stack_push(s, &data);
+            return stack_pop(s, &buf);
+        };
+
+        stack_destroy(s);
+    }
+}
+
+SCENARIO("一括操作のコストを計測する", tags(".", "benchmark", "stack_push_n", "stack_pop_n")) {
+
+    GIVEN("スタックを作成する") {
+        static const int BURST = 64;
+        stack_t s;
+        int data[BURST], buf[BURST];
+
+        REQUIRE((s = stack_create(sizeof(int), 1024)) != NULL);
+
+        BENCHMARK("push / pop x64") {
+            for (int i = 0; i < BURST; ++i) {
+                stack_push(s, &data[i]);
+            }
+            for (int i = 0; i < BURST; ++i) {
+                stack_pop(s, &buf[i]);
+            }
+            return buf[0];
+        };
+        BENCHMARK("push_n / pop_n x64") {
+            stack_push_n(s, data, BURST);
+            return stack_pop_n(s, buf, BURST);
+        };
+
+        stack_destroy(s);
+    }
+}
+
+SCENARIO("ゼロコピー操作のコストを計測する",
+         tags(".", "benchmark", "stack_push_reserve", "stack_pop_acquire")) {
+
+    for (size_t bytes: {256, 1024}) {
+        GIVEN(std::to_string(bytes) + " バイトのデータのスタックを作成する") {
+            stack_t s;
+            std::vector<uint8_t> record(bytes, 0x5a), buf(bytes);
+
+            REQUIRE((s = stack_create(bytes, 1024)) != NULL);
+
+            BENCHMARK("push / pop " + std::to_string(bytes) + " bytes") {
+                record[0] += 1;
+                stack_push(s, record.data());
+                stack_pop(s, buf.data());
+                return buf[0];
+            };
+            BENCHMARK("reserve / commit / acquire / release " + std::to_string(bytes) + " bytes") {
+                uint8_t *value = (uint8_t *)stack_push_reserve(s);
+                value[0] += 1;
+                stack_push_commit(s, value);
+                value = (uint8_t *)stack_pop_acquire(s);
+                uint8_t first = value[0];
+                stack_pop_release(s, value);
+                return first;
+            };
+
+            stack_destroy(s);
+        }
+    }
+}
+
+SCENARIO("ノード配置 (AoS / SoA) ごとのメモリ量とコストを計測する",
+         tags(".", "benchmark", "stack_create_flags", "layout")) {
+
+    static const size_t CAPACITY = 1 << 20;
+    static const int BURST = 1 << 16;
+
+    for (unsigned int flags: {0U, STACK_FLAG_SOA}) {
+        std::string name = (flags & STACK_FLAG_SOA) ? "soa" : "aos";
+
+        GIVEN(name + " のスタックを作成する") {
+            stack_t s;
+            std::vector<int> data(BURST), buf(BURST);
+
+            struct mallinfo2 before = mallinfo2();
+            REQUIRE((s = stack_create_flags(sizeof(int), CAPACITY, flags)) != NULL);
+            struct mallinfo2 after = mallinfo2();
+            size_t bytes = (after.uordblks + after.hblkhd) - (before.uordblks + before.hblkhd);
+            WARN(name + ": " + std::to_string((double)bytes / CAPACITY) + " bytes/element");
+
+            BENCHMARK(name + " push / pop") {
+                stack_push(s, &data[0]);
+                return stack_pop(s, &buf[0]);
+            };
+            BENCHMARK(name + " push_n / pop_n x65536") {
+                stack_push_n(s, data.data(), BURST);
+                return stack_pop_n(s, buf.data(), BURST);
+            };
+
+            stack_destroy(s);
+        }
+    }
+}
+
+/**
+ *  Runs @c threads threads, each doing @c ops balanced push/pop pairs.
+ */
+static void run_balanced(stack_t s, int threads, int ops)
+{
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([=] {
+            int data = t, buf;
+            for (int i = 0; i < ops; ++i) {
+                stack_push(s, &data);
+                stack_pop(s, &buf);
+            }
+        });
+    }
+    for (auto &w: workers) {
+        w.join();
+    }
+}
+
+SCENARIO("エリミネーション/CPU 毎の分割の効果をスレッド数ごとに計測する",
+         tags(".", "benchmark", "stack_create_flags", "parallel")) {
+
+    static const int OPS = 10000;
+
+    for (unsigned int flags: {0U, STACK_FLAG_ELIMINATION, STACK_FLAG_PERCPU}) {
+        std::string name = (flags & STACK_FLAG_ELIMINATION) ? "elimination"
+                         : (flags & STACK_FLAG_PERCPU) ? "percpu" : "plain";
+
+        GIVEN(name + " のスタックを作成する") {
+            stack_t s;
+
+            REQUIRE((s = stack_create_flags(sizeof(int), 1024, flags)) != NULL);
+
+            for (int threads: {1, 2, 4, 8, 16}) {
+                BENCHMARK(name + " " + std::to_string(threads) + " threads") {
+                    run_balanced(s, threads, OPS);
+                };
+            }
+
+            stack_destroy(s);
+        }
+    }
+}
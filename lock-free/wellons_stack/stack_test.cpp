@@ -9,6 +9,7 @@
  */
 #include <sched.h>
 #include <pthread.h>
+#include <vector>
 #include <catch2/catch.hpp>
 
 #include "utils.hpp"
@@ -79,6 +80,290 @@ SCENARIO("スタックへのデータの追加/取得が繰り返しできるこ
     }
 }
 
+SCENARIO("スタックへのデータの一括追加/取得ができること",
+         tags("stack", "stack_push_n", "stack_pop_n", "stack_pop_all")) {
+
+    GIVEN("サイズの十分なスタックを作成する") {
+        stack_t s;
+        size_t capacity{8};
+
+        INFO("容量: " + std::to_string(capacity));
+
+        REQUIRE((s = stack_create(sizeof(int), capacity)) != NULL);
+
+        WHEN("スタックへ一括でデータを追加する") {
+            int data[]{10, 20, 30, 40, 50};
+
+            INFO("データ: " + array_to_string(data));
+
+            THEN("１件ずつ追加した場合と同じ順序で取得できること") {
+                CHECK(stack_push_n(s, data, 5) == 5);
+                CHECK(stack_size(s) == 5);
+                int buf[3];
+                CHECK(stack_pop_n(s, buf, 3) == 3);
+                CHECK(buf[0] == 50);
+                CHECK(buf[1] == 40);
+                CHECK(buf[2] == 30);
+                CHECK((stack_pop(s, buf)?:buf[0]) == 20);
+                CHECK(stack_pop_n(s, buf, 3) == 1);
+                CHECK(buf[0] == 10);
+                CHECK(stack_pop_n(s, buf, 3) == -1);
+                CHECK(errno == ENOMEM);
+            }
+
+            THEN("空き容量を超えた分は追加されないこと") {
+                CHECK(stack_push_n(s, data, 5) == 5);
+                CHECK(stack_push_n(s, data, 5) == 3);
+                CHECK(stack_push_n(s, data, 5) == -1);
+                CHECK(errno == ENOMEM);
+                CHECK(stack_size(s) == capacity);
+            }
+        }
+
+        WHEN("スタックから全てのデータを取り出す") {
+            int data[]{10, 20, 30, 40};
+
+            INFO("データ: " + array_to_string(data));
+
+            REQUIRE(stack_push_n(s, data, 4) == 4);
+
+            THEN("先頭から順に全てのデータが取得でき、容量が再利用できること") {
+                std::vector<int> drained;
+                auto drain = [](void *value, void *arg) {
+                    ((std::vector<int> *)arg)->push_back(*(int *)value);
+                };
+                CHECK(stack_pop_all(s, drain, &drained) == 4);
+                CHECK(drained == std::vector<int>({40, 30, 20, 10}));
+                CHECK(stack_size(s) == 0);
+                CHECK(stack_pop_all(s, drain, &drained) == -1);
+                CHECK(stack_push_n(s, data, 4) == 4);
+                CHECK(stack_push_n(s, data, 4) == 4);
+            }
+        }
+
+        stack_destroy(s);
+    }
+}
+
+SCENARIO("スタックのノードを直接読み書きできること",
+         tags("stack", "stack_push_reserve", "stack_push_commit",
+              "stack_pop_acquire", "stack_pop_release")) {
+
+    GIVEN("サイズの十分なスタックを作成する") {
+        stack_t s;
+        size_t capacity{2};
+
+        INFO("容量: " + std::to_string(capacity));
+
+        REQUIRE((s = stack_create(sizeof(int), capacity)) != NULL);
+
+        WHEN("ノードを予約してデータを書き込み、確定する") {
+            int *value;
+            REQUIRE((value = (int *)stack_push_reserve(s)) != NULL);
+            *value = 10;
+            REQUIRE(stack_push_commit(s, value) == 0);
+            REQUIRE((value = (int *)stack_push_reserve(s)) != NULL);
+            *value = 20;
+            REQUIRE(stack_push_commit(s, value) == 0);
+
+            THEN("容量を超えた予約はできないこと") {
+                CHECK(stack_push_reserve(s) == NULL);
+                CHECK(errno == ENOMEM);
+                CHECK(stack_size(s) == 2);
+            }
+
+            THEN("取り出したノードから直接データを読み出せること") {
+                int *top;
+                REQUIRE((top = (int *)stack_pop_acquire(s)) != NULL);
+                CHECK(*top == 20);
+                CHECK(stack_size(s) == 1);
+                CHECK(stack_pop_release(s, top) == 0);
+                REQUIRE((top = (int *)stack_pop_acquire(s)) != NULL);
+                CHECK(*top == 10);
+                CHECK(stack_pop_acquire(s) == NULL);
+                CHECK(errno == ENOMEM);
+                CHECK(stack_pop_release(s, top) == 0);
+            }
+        }
+
+        WHEN("予約したノードを確定せずに返却する") {
+            void *value;
+            REQUIRE((value = stack_push_reserve(s)) != NULL);
+            REQUIRE(stack_pop_release(s, value) == 0);
+
+            THEN("容量が再利用できること") {
+                int data = 30;
+                CHECK(stack_push(s, &data) == 0);
+                CHECK(stack_push(s, &data) == 0);
+                CHECK(stack_size(s) == 2);
+            }
+        }
+
+        stack_destroy(s);
+    }
+}
+
+SCENARIO("容量を超えるとスタックが拡張/縮小されること",
+         tags("stack", "stack_create_flags", "stack_capacity")) {
+
+    GIVEN("拡張/縮小可能なスタックを作成する") {
+        stack_t s;
+        size_t capacity{4};
+
+        INFO("容量: " + std::to_string(capacity));
+
+        REQUIRE((s = stack_create_flags(sizeof(int), capacity, STACK_FLAG_SHRINKABLE)) != NULL);
+        REQUIRE(stack_capacity(s) == capacity);
+
+        WHEN("初期容量を超えてデータを追加する") {
+            static const int TEST_COUNT = 100;
+
+            for (int i = 0; i < TEST_COUNT; ++i) {
+                REQUIRE(stack_push(s, &i) == 0);
+            }
+
+            THEN("容量が倍々に拡張され、全てのデータが取得できること") {
+                CHECK(stack_size(s) == TEST_COUNT);
+                CHECK(stack_capacity(s) == 124);    /* 4 + 8 + 16 + 32 + 64 */
+                for (int i = TEST_COUNT - 1; i >= 0; --i) {
+                    int buf = -1;
+                    CHECK((stack_pop(s, &buf)?:buf) == i);
+                }
+            }
+
+            THEN("取り出すにつれて容量が縮小されること") {
+                int buf;
+                while (stack_pop(s, &buf) == 0) {
+                }
+                CHECK(stack_size(s) == 0);
+                CHECK(stack_capacity(s) == capacity);
+                CHECK(stack_push(s, &buf) == 0);
+            }
+        }
+
+        stack_destroy(s);
+    }
+
+    GIVEN("拡張のみ可能なスタックを作成する") {
+        stack_t s;
+        size_t capacity{4};
+
+        REQUIRE((s = stack_create_flags(sizeof(int), capacity, STACK_FLAG_GROWABLE)) != NULL);
+
+        WHEN("一括でデータを追加/取得する") {
+            int data[10]{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}, buf[10];
+
+            REQUIRE(stack_push_n(s, data, 10) == 4);
+            REQUIRE(stack_push_n(s, data + 4, 6) == 6);
+
+            THEN("取り出しても容量は縮小されないこと") {
+                CHECK(stack_pop_n(s, buf, 10) == 10);
+                CHECK(buf[0] == 9);
+                CHECK(buf[9] == 0);
+                CHECK(stack_capacity(s) == 12);
+            }
+        }
+
+        stack_destroy(s);
+    }
+}
+
+SCENARIO("SoA 配置のスタックへのデータの追加/取得ができること",
+         tags("stack", "stack_create_flags", "stack_push", "stack_pop")) {
+
+    GIVEN("SoA 配置で拡張可能なスタックを作成する") {
+        struct record {
+            uint8_t bytes[3];
+        };
+        stack_t s;
+        size_t capacity{2};
+
+        INFO("容量: " + std::to_string(capacity));
+
+        REQUIRE((s = stack_create_flags(sizeof(struct record), capacity,
+                                        STACK_FLAG_SOA | STACK_FLAG_SHRINKABLE)) != NULL);
+
+        WHEN("初期容量を超えてデータを追加する") {
+            static const int TEST_COUNT = 20;
+
+            for (int i = 0; i < TEST_COUNT; ++i) {
+                struct record data{{(uint8_t)i, (uint8_t)(i + 1), (uint8_t)(i + 2)}};
+                REQUIRE(stack_push(s, &data) == 0);
+            }
+
+            THEN("全てのデータが壊れずに取得できること") {
+                CHECK(stack_size(s) == TEST_COUNT);
+                for (int i = TEST_COUNT - 1; i >= 0; --i) {
+                    struct record buf{};
+                    REQUIRE(stack_pop(s, &buf) == 0);
+                    CHECK(buf.bytes[0] == i);
+                    CHECK(buf.bytes[2] == i + 2);
+                }
+                CHECK(stack_capacity(s) == capacity);
+            }
+
+            THEN("ノードを直接読み書きできること") {
+                struct record *value;
+                REQUIRE((value = (struct record *)stack_pop_acquire(s)) != NULL);
+                CHECK(value->bytes[0] == TEST_COUNT - 1);
+                CHECK(stack_pop_release(s, value) == 0);
+                REQUIRE((value = (struct record *)stack_push_reserve(s)) != NULL);
+                value->bytes[0] = 99;
+                CHECK(stack_push_commit(s, value) == 0);
+                struct record buf{};
+                CHECK((stack_pop(s, &buf)?:buf.bytes[0]) == 99);
+            }
+        }
+
+        stack_destroy(s);
+    }
+
+    GIVEN("SoA 配置と CPU 毎の分割を同時に指定する") {
+
+        THEN("スタックが作成できないこと") {
+            CHECK(stack_create_flags(sizeof(int), 1, STACK_FLAG_SOA | STACK_FLAG_PERCPU) == NULL);
+            CHECK(errno == EINVAL);
+        }
+    }
+}
+
+SCENARIO("空のスタックからの取得を待機できること", tags("stack", "stack_pop_wait")) {
+
+    GIVEN("サイズの十分なスタックを作成する") {
+        stack_t s;
+        size_t capacity{10};
+
+        REQUIRE((s = stack_create(sizeof(int), capacity)) != NULL);
+
+        WHEN("空のまま待機する") {
+
+            THEN("タイムアウトすること") {
+                int buf;
+                CHECK(stack_pop_wait(s, &buf, 20) == -1);
+                CHECK(errno == ETIMEDOUT);
+            }
+        }
+
+        WHEN("別のスレッドから遅れてデータを追加する") {
+            auto pusher = [&](void *) -> void * {
+                int data = 10;
+                msleep(20);
+                return (void *)(intptr_t)stack_push(s, &data);
+            };
+            pthread_t thr;
+            REQUIRE(pthread_create(&thr, NULL, Lambda::ptr<void *, void *>(pusher), NULL) == 0);
+
+            THEN("追加されたデータが取得できること") {
+                int buf = -1;
+                CHECK((stack_pop_wait(s, &buf, -1)?:buf) == 10);
+                REQUIRE(pthread_join(thr, NULL) == 0);
+            }
+        }
+
+        stack_destroy(s);
+    }
+}
+
 SCENARIO("スタックへの並列アクセスが可能であること",
          tags("stack", "stack_push", "stack_pop", "parallel")) {
 
@@ -125,7 +410,7 @@ SCENARIO("スタックへの並列アクセスが可能であること",
             pthread_t pusher_thr1, pusher_thr2;
             struct param param_thr1 = {.count = TEST_COUNT, .offset = 0, .callback = pusher},
                          param_thr2 = {.count = TEST_COUNT, .offset = TEST_COUNT, .callback = pusher};
-            int count = 0;
+            intptr_t count = 0;
             REQUIRE(pthread_create(&pusher_thr1, NULL, Lambda::ptr<void *, void *>(worker), &param_thr1) == 0);
             REQUIRE(pthread_create(&pusher_thr2, NULL, Lambda::ptr<void *, void *>(worker), &param_thr2) == 0);
             msleep(10);
@@ -157,3 +442,307 @@ SCENARIO("スタックへの並列アクセスが可能であること",
         stack_destroy(s);
     }
 }
+
+/**
+ *  Creates a stack with @c flags, pushes 2 * 10000 values from two
+ *  threads while two others pop them, then checks that every value came
+ *  out exactly once. Skipped when @c flags are not all in effect.
+ */
+static void push_pop_in_parallel(unsigned int flags)
+{
+    static const int TEST_COUNT = 10000;
+
+    stack_t s;
+    REQUIRE((s = stack_create_flags(sizeof(int), TEST_COUNT * 2, flags)) != NULL);
+
+    struct stack_stats stats;
+    REQUIRE(stack_get_stats(s, &stats) == 0);
+    if ((stats.flags & flags) != flags) {
+        WARN("指定した方式が使えないため省略する");
+        stack_destroy(s);
+        return;
+    }
+    if (flags & STACK_FLAG_PERCPU) {
+        REQUIRE(stats.nshards > 0);
+    }
+
+    struct param {
+        int count;
+        int offset;
+        std::function<int(int)> callback;
+    };
+    auto worker = [&](void *arg) -> void * {
+        struct param *prm = (struct param *)arg;
+        for (int i = 0; i < prm->count; ++i) {
+            if (prm->callback(prm->offset + i) != 0) {
+                return (void *)(intptr_t)i;
+            }
+        }
+        return (void *)(intptr_t)prm->count;
+    };
+
+    auto pusher = [&](int data) -> int {
+        return stack_push(s, &data);
+    };
+    BITFLAG bf = bitflag_create(TEST_COUNT * 2);
+    auto poper = [&](int) -> int {
+        int buf = -1;
+        while (stack_pop(s, &buf) != 0) {
+            sched_yield();
+        }
+        return bitflag_set(bf, buf);
+    };
+
+    pthread_t thr[4];
+    struct param prm[4] = {
+        {.count = TEST_COUNT, .offset = 0, .callback = pusher},
+        {.count = TEST_COUNT, .offset = TEST_COUNT, .callback = pusher},
+        {.count = TEST_COUNT, .offset = 0, .callback = poper},
+        {.count = TEST_COUNT, .offset = 0, .callback = poper},
+    };
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(pthread_create(&thr[i], NULL, Lambda::ptr<void *, void *>(worker), &prm[i]) == 0);
+    }
+    intptr_t count = 0;
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE((pthread_join(thr[i], (void **)&count)?:count) == TEST_COUNT);
+    }
+
+    bool is_all_set = true;
+    for (int i = 0; i < (TEST_COUNT * 2); ++i) {
+        if (!bitflag_check(bf, i)) {
+            is_all_set = false;
+        }
+    }
+    CHECK(is_all_set == true);
+    CHECK(stack_size(s) == 0);
+
+    bitflag_destroy(bf);
+    stack_destroy(s);
+}
+
+SCENARIO("エリミネーション付きスタックへの並列アクセスが可能であること",
+         tags("stack", "stack_create_flags", "stack_push", "stack_pop", "parallel")) {
+
+    GIVEN("エリミネーション付きのスタックを作成する") {
+
+        WHEN("４つのスレッドから同時に追加/取得する (push / pop)") {
+
+            THEN("データが追加/取得できること") {
+                push_pop_in_parallel(STACK_FLAG_ELIMINATION);
+            }
+        }
+    }
+}
+
+SCENARIO("衝突した追加と取得がエリミネーションで直接受け渡されること",
+         tags("stack", "stack_create_flags", "stack_push", "stack_pop", "stack_get_stats", "parallel")) {
+
+    GIVEN("要素を１つ持つエリミネーション付きのスタックを作成する") {
+        stack_t s;
+        size_t capacity{8};
+
+        REQUIRE((s = stack_create_flags(sizeof(int), capacity, STACK_FLAG_ELIMINATION)) != NULL);
+
+        int bottom = 7;
+        REQUIRE(stack_push(s, &bottom) == 0);
+
+        WHEN("先頭の CAS を全て失敗させて、追加と取得を同時に行う") {
+            REQUIRE(stack_debug_contend(s, SIZE_MAX) == 0);
+
+            int data = 42;
+            int popped = -1;
+            auto pusher = [&](void *) -> void * {
+                return (void *)(intptr_t)stack_push(s, &data);
+            };
+            auto poper = [&](void *) -> void * {
+                return (void *)(intptr_t)stack_pop(s, &popped);
+            };
+            pthread_t thr[2];
+            REQUIRE(pthread_create(&thr[0], NULL, Lambda::ptr<void *, void *>(pusher), NULL) == 0);
+            REQUIRE(pthread_create(&thr[1], NULL, Lambda::ptr<void *, void *>(poper), NULL) == 0);
+
+            intptr_t ret = -1;
+            for (int i = 0; i < 2; ++i) {
+                REQUIRE((pthread_join(thr[i], (void **)&ret)?:ret) == 0);
+            }
+
+            THEN("先頭に触れずにデータが受け渡されること") {
+                REQUIRE(popped == 42);
+
+                struct stack_stats stats;
+                REQUIRE(stack_get_stats(s, &stats) == 0);
+                REQUIRE(stats.eliminated == 1);
+
+                REQUIRE(stack_debug_contend(s, 0) == 0);
+                int buf = -1;
+                REQUIRE(stack_pop(s, &buf) == 0);
+                REQUIRE(buf == 7);
+                REQUIRE(stack_pop(s, &buf) == -1);
+                REQUIRE(errno == ENOMEM);
+            }
+        }
+
+        stack_destroy(s);
+    }
+}
+
+SCENARIO("エリミネーションの幅が衝突で広がり、時間切れで狭まること",
+         tags("stack", "stack_create_flags", "stack_push", "stack_get_stats", "parallel")) {
+
+    GIVEN("エリミネーション付きのスタックを作成する") {
+        stack_t s;
+        size_t capacity{8};
+
+        REQUIRE((s = stack_create_flags(sizeof(int), capacity, STACK_FLAG_ELIMINATION)) != NULL);
+
+        struct stack_stats stats;
+        REQUIRE(stack_get_stats(s, &stats) == 0);
+        REQUIRE(stats.width == 1);
+
+        WHEN("先頭の CAS を全て失敗させて、２つのスレッドから同時に追加する") {
+            REQUIRE(stack_debug_contend(s, SIZE_MAX) == 0);
+
+            auto pusher = [&](void *) -> void * {
+                int data = 0;
+                return (void *)(intptr_t)stack_push(s, &data);
+            };
+            pthread_t thr[2];
+            for (int i = 0; i < 2; ++i) {
+                REQUIRE(pthread_create(&thr[i], NULL, Lambda::ptr<void *, void *>(pusher), NULL) == 0);
+            }
+
+            int64_t base = getuptime(0);
+            do {
+                msleep(1);
+                stack_get_stats(s, &stats);
+            } while (((stats.widened == 0) || (stats.narrowed == 0))
+                     && (getuptime(base) < 10000));
+            REQUIRE(stack_debug_contend(s, 0) == 0);
+
+            intptr_t ret = -1;
+            for (int i = 0; i < 2; ++i) {
+                REQUIRE((pthread_join(thr[i], (void **)&ret)?:ret) == 0);
+            }
+
+            THEN("重なった申し出で幅が広がり、取り手のない申し出で狭まること") {
+                REQUIRE(stats.widened > 0);
+                REQUIRE(stats.narrowed > 0);
+
+                /* every timed-out offer halves the width down to 1. */
+                REQUIRE(stack_get_stats(s, &stats) == 0);
+                size_t halvings = 0;
+                for (size_t w = stats.width; w > 1; w /= 2) {
+                    ++halvings;
+                }
+                REQUIRE(stack_debug_contend(s, 3) == 0);
+                int data = 0;
+                REQUIRE(stack_push(s, &data) == 0);
+
+                struct stack_stats after;
+                REQUIRE(stack_get_stats(s, &after) == 0);
+                REQUIRE(after.width == 1);
+                REQUIRE(after.narrowed - stats.narrowed == halvings);
+            }
+        }
+
+        WHEN("１つのスレッドから、先頭の CAS を失敗させて追加する") {
+            REQUIRE(stack_debug_contend(s, 3) == 0);
+
+            int data = 0;
+            REQUIRE(stack_push(s, &data) == 0);
+
+            THEN("申し出が時間切れになるだけで、幅は広がらないこと") {
+                REQUIRE(stack_get_stats(s, &stats) == 0);
+                REQUIRE(stats.width == 1);
+                REQUIRE(stats.widened == 0);
+                REQUIRE(stats.eliminated == 0);
+                REQUIRE(stack_size(s) == 1);
+            }
+        }
+
+        stack_destroy(s);
+    }
+}
+
+SCENARIO("CPU 毎に分割したスタックへの並列アクセスが可能であること",
+         tags("stack", "stack_create_flags", "stack_push", "stack_pop", "parallel")) {
+
+    GIVEN("CPU 毎に分割したスタックを作成する") {
+
+        WHEN("４つのスレッドから同時に追加/取得する (push / pop)") {
+
+            THEN("データが追加/取得できること") {
+                push_pop_in_parallel(STACK_FLAG_PERCPU);
+            }
+        }
+    }
+}
+
+SCENARIO("他の CPU で追加されたデータを取得できること",
+         tags("stack", "stack_create_flags", "stack_push", "stack_pop", "stack_get_stats")) {
+
+    GIVEN("CPU 毎に分割したスタックを作成する") {
+        stack_t s;
+        size_t capacity{64};
+
+        REQUIRE((s = stack_create_flags(sizeof(int), capacity, STACK_FLAG_PERCPU)) != NULL);
+
+        struct stack_stats stats;
+        REQUIRE(stack_get_stats(s, &stats) == 0);
+        if (!(stats.flags & STACK_FLAG_PERCPU)) {
+            WARN("rseq が使えないため省略する");
+            stack_destroy(s);
+            return;
+        }
+
+        cpu_set_t allowed;
+        REQUIRE(sched_getaffinity(0, sizeof(allowed), &allowed) == 0);
+        std::vector<int> cpus;
+        for (int cpu = 0; (cpu < CPU_SETSIZE) && ((size_t)cpu < stats.nshards) && (cpus.size() < 2); ++cpu) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                cpus.push_back(cpu);
+            }
+        }
+        if (cpus.size() < 2) {
+            WARN("使える CPU が１つしかないため省略する");
+            stack_destroy(s);
+            return;
+        }
+
+        INFO("CPU: " + std::to_string(cpus[0]) + " -> " + std::to_string(cpus[1]));
+
+        WHEN("一方の CPU で追加し、もう一方の CPU で取得する") {
+            int popped = -1;
+            auto migrant = [&](void *) -> void * {
+                cpu_set_t set;
+                int data = 42;
+
+                CPU_ZERO(&set);
+                CPU_SET(cpus[0], &set);
+                if ((sched_setaffinity(0, sizeof(set), &set) != 0) || (stack_push(s, &data) != 0)) {
+                    return (void *)(intptr_t)-1;
+                }
+                CPU_ZERO(&set);
+                CPU_SET(cpus[1], &set);
+                if ((sched_setaffinity(0, sizeof(set), &set) != 0) || (stack_pop(s, &popped) != 0)) {
+                    return (void *)(intptr_t)-1;
+                }
+                return (void *)(intptr_t)0;
+            };
+            pthread_t thr;
+            intptr_t ret = -1;
+            REQUIRE(pthread_create(&thr, NULL, Lambda::ptr<void *, void *>(migrant), NULL) == 0);
+            REQUIRE((pthread_join(thr, (void **)&ret)?:ret) == 0);
+
+            THEN("追加した CPU の分割から盗んで取得できること") {
+                REQUIRE(popped == 42);
+                REQUIRE(stack_get_stats(s, &stats) == 0);
+                REQUIRE(stats.stolen == 1);
+                REQUIRE(stack_size(s) == 0);
+            }
+        }
+
+        stack_destroy(s);
+    }
+}